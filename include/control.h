@@ -22,6 +22,7 @@ namespace core {
 class Manager;
 class ViewManager;
 class DhtManager;
+class WatchDirectories;
 }
 
 namespace display {
@@ -39,10 +40,6 @@ class XmlRpc;
 class object_storage;
 }
 
-namespace torrent {
-class directory_events;
-}
-
 class Control {
 public:
   Control();
@@ -100,8 +97,8 @@ public:
     return m_objectStorage;
   }
 
-  torrent::directory_events* directory_events() {
-    return m_directory_events;
+  core::WatchDirectories* watch_directories() {
+    return m_watchDirectories;
   }
 
   uint64_t tick() const {
@@ -133,9 +130,9 @@ private:
 
   std::atomic<uint8_t> lt_cacheline_aligned m_shutdownQuick{ 0 };
 
-  rpc::CommandScheduler*     m_commandScheduler;
-  rpc::object_storage*       m_objectStorage;
-  torrent::directory_events* m_directory_events;
+  rpc::CommandScheduler*  m_commandScheduler;
+  rpc::object_storage*    m_objectStorage;
+  core::WatchDirectories* m_watchDirectories;
 
   uint64_t m_tick{ 0 };
 
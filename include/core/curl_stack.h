@@ -115,6 +115,16 @@ public:
     m_dns_timeout = timeout;
   }
 
+  // Keep connections open between transfers, sharing them along with
+  // the DNS cache and TLS sessions through a curl share handle.
+  bool reuse_connections() const {
+    return m_reuseConnections;
+  }
+  void set_reuse_connections(bool s);
+
+  // Applies the connection reuse settings to a new easy handle.
+  void prepare_handle(void* handle);
+
   static void global_init();
   static void global_cleanup();
 
@@ -134,6 +144,7 @@ private:
   bool process_done_handle();
 
   void* m_handle;
+  void* m_share{ nullptr };
 
   unsigned int m_active{ 0 };
   unsigned int m_maxActive{ 32 };
@@ -149,6 +160,7 @@ private:
   bool m_ssl_verify_host{ true };
   bool m_ssl_verify_peer{ true };
   long m_dns_timeout{ 60 };
+  bool m_reuseConnections{ false };
 };
 
 }
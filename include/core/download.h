@@ -150,6 +150,19 @@ public:
 
   float distributed_copies() const;
 
+  // Checksum and size of the session sections when they were last
+  // saved, a size of zero meaning they have not been saved yet.
+  uint32_t session_checksum() const {
+    return m_sessionChecksum;
+  }
+  uint64_t session_size() const {
+    return m_sessionSize;
+  }
+  void set_session_saved(uint32_t checksum, uint64_t size) {
+    m_sessionChecksum = checksum;
+    m_sessionSize     = size;
+  }
+
   // HACK: Choke group setting.
   unsigned int group() const {
     return m_group;
@@ -172,6 +185,8 @@ private:
   std::string   m_message;
   uint32_t      m_resumeFlags;
   unsigned int  m_group;
+  uint32_t      m_sessionChecksum{ 0 };
+  uint64_t      m_sessionSize{ 0 };
 };
 
 inline bool
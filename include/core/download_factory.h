@@ -19,6 +19,7 @@
 namespace core {
 
 class Manager;
+struct SessionEntry;
 
 class DownloadFactory {
 public:
@@ -34,6 +35,10 @@ public:
   // load() or commit().
   void load(const std::string& uri);
   void load_raw_data(const std::string& input);
+
+  // Takes a session torrent already read by SessionLoader, including
+  // its '.rtorrent' and '.libtorrent_resume' sections.
+  void load_session(SessionEntry&& entry);
   void commit();
 
   command_list_type& commands() {
@@ -74,6 +79,14 @@ public:
     m_immediate = v;
   }
 
+  // HttpQueue priority class used when the uri is fetched over http.
+  int http_priority() const {
+    return m_httpPriority;
+  }
+  void set_http_priority(int p) {
+    m_httpPriority = p;
+  }
+
   void slot_finished(slot_void s) {
     m_slot_finished = s;
   }
@@ -103,10 +116,15 @@ private:
   bool        m_printLog{ true };
   bool        m_immediate{ false };
   bool        m_isFile{ false };
+  bool        m_preloaded{ false };
+  int         m_httpPriority{ HttpQueue::priority_interactive };
 
   command_list_type         m_commands;
   torrent::Object::map_type m_variables;
 
+  torrent::Object m_sessionRtorrent;
+  torrent::Object m_sessionResume;
+
   slot_void                     m_slot_finished;
   torrent::utils::priority_item m_taskLoad;
   torrent::utils::priority_item m_taskCommit;
@@ -4,18 +4,29 @@
 #ifndef RTORRENT_CORE_DOWNLOAD_LIST_H
 #define RTORRENT_CORE_DOWNLOAD_LIST_H
 
+#include <cstring>
 #include <iosfwd>
 #include <list>
 #include <string>
+#include <unordered_map>
 
-namespace torrent {
-class HashString;
-}
+#include <torrent/hash_string.h>
+
+class DownloadListTest;
 
 namespace core {
 
 class Download;
 
+// Info-hashes are SHA1 digests, so any of their bytes make a good hash.
+struct download_hash_string_hash {
+  size_t operator()(const torrent::HashString& hash) const {
+    size_t result;
+    std::memcpy(&result, &*hash.begin(), sizeof(result));
+    return result;
+  }
+};
+
 // Container for all downloads. Add slots to the slot maps to cause
 // some action to be taken when the torrent changes states. Don't
 // change the states from outside of core.
@@ -24,7 +35,11 @@ class Download;
 
 class DownloadList : private std::list<Download*> {
 public:
+  friend class ::DownloadListTest;
+
   using base_type = std::list<Download*>;
+  using hash_index =
+    std::unordered_map<torrent::HashString, base_type::iterator, download_hash_string_hash>;
 
   using base_type::const_iterator;
   using base_type::const_reverse_iterator;
@@ -154,6 +169,16 @@ private:
   void received_inactive(Download* d);
 
   void process_meta_download(Download* d);
+
+  // Keep the list and 'm_hashIndex' in sync, taking the info-hash of
+  // 'd' so they don't need to look into the download.
+  iterator insert_indexed(Download* d, const torrent::HashString& hash);
+  iterator erase_indexed(iterator itr, const torrent::HashString& hash);
+  iterator find_indexed(Download* d, const torrent::HashString& hash);
+
+  // Kept in sync by 'insert' and 'erase' so hash lookups, e.g. by RPC
+  // targets, don't scan the list.
+  hash_index m_hashIndex;
 };
 
 }
@@ -4,8 +4,12 @@
 #ifndef RTORRENT_CORE_DOWNLOAD_STORE_H
 #define RTORRENT_CORE_DOWNLOAD_STORE_H
 
+#include <atomic>
 #include <string>
+#include <vector>
 
+#include "core/session_snapshot.h"
+#include "core/session_writer.h"
 #include "utils/lockfile.h"
 
 namespace utils {
@@ -32,6 +36,43 @@ public:
   }
   void set_path(const std::string& path);
 
+  // Keep the 'rtorrent' and 'libtorrent_resume' sections in a single
+  // snapshot file instead of two files per torrent.
+  bool use_snapshot() const {
+    return m_useSnapshot;
+  }
+  void set_use_snapshot(bool v);
+
+  SessionSnapshot* snapshot() {
+    return m_snapshot.is_open() ? &m_snapshot : nullptr;
+  }
+
+  // Called after saving the session.
+  void sync_snapshot();
+
+  // Set while saved torrents are still being written.
+  bool is_saving() const {
+    return m_writer.is_busy();
+  }
+
+  // Torrents whose sections were written or skipped as unchanged, and
+  // the bytes written, since startup. Updated by the writer thread.
+  uint64_t saved_torrents() const {
+    return m_savedTorrents;
+  }
+  uint64_t skipped_torrents() const {
+    return m_skippedTorrents;
+  }
+  uint64_t saved_bytes() const {
+    return m_savedBytes;
+  }
+
+  // Torrents whose files couldn't be written, retried by their next
+  // save.
+  uint64_t failed_torrents() const {
+    return m_writer.failed_jobs();
+  }
+
   bool save(Download* d, int flags);
   bool save_full(Download* d) {
     return save(d, 0);
@@ -46,15 +87,44 @@ public:
 
   static bool is_correct_format(const std::string& f);
 
+  // Replaces 'filename' with the bencoded 'obj', using a temporary
+  // file that is synced and renamed into place. A map gets a checksum
+  // of its encoding as an extra key.
+  static bool write_bencode(const std::string&     filename,
+                            const torrent::Object& obj,
+                            uint32_t               skip_mask,
+                            uint64_t*              size = nullptr);
+
+  // Decodes a file written by write_bencode(), failing if its checksum
+  // doesn't match, and removes the checksum key. Files without one are
+  // only decoded.
+  static bool read_bencode(const std::string& filename, torrent::Object* obj);
+
 private:
+  std::string create_id(Download* d);
   std::string create_filename(Download* d);
 
-  bool write_bencode(const std::string&     filename,
-                     const torrent::Object& obj,
-                     uint32_t               skip_mask);
+  bool write_sections(const std::string&     id,
+                      const std::string&     base_filename,
+                      const torrent::Object& rtorrent,
+                      const torrent::Object& resume);
+  bool write_static(const std::string& filename, const torrent::Object& object);
 
   std::string     m_path;
   utils::Lockfile m_lockfile;
+  bool            m_useSnapshot{ false };
+  SessionSnapshot m_snapshot;
+
+  std::atomic<uint64_t> m_savedTorrents{ 0 };
+  std::atomic<uint64_t> m_skippedTorrents{ 0 };
+  std::atomic<uint64_t> m_savedBytes{ 0 };
+
+  // Section files of torrents first written to the snapshot, removed
+  // once it is synced. Only used by the writer thread.
+  std::vector<std::string> m_supersededFiles;
+
+  // Declared last so it is stopped before the snapshot is closed.
+  SessionWriter m_writer;
 };
 
 }
@@ -7,11 +7,16 @@
 #include <functional>
 #include <iosfwd>
 #include <list>
+#include <string>
+#include <unordered_map>
 
 namespace core {
 
 class CurlGet;
 
+// Transfers are started in priority order, and only as long as the
+// number of active transfers, both in total and to a single host, is
+// below the limits. The rest wait in the queue.
 class HttpQueue : private std::list<CurlGet*> {
 public:
   using base_type       = std::list<CurlGet*>;
@@ -32,6 +37,13 @@ public:
   using base_type::empty;
   using base_type::size;
 
+  enum priority_type {
+    priority_interactive,
+    priority_watch,
+    priority_feed,
+    priority_size
+  };
+
   ~HttpQueue() {
     clear();
   }
@@ -41,11 +53,32 @@ public:
   //
   // Consider adding a flag to indicate whetever HttpQueue should
   // delete the stream.
-  iterator insert(const std::string& url, std::iostream* s);
+  iterator insert(const std::string& url,
+                  std::iostream*     s,
+                  int                priority = priority_interactive);
   void     erase(iterator itr);
 
   void clear();
 
+  unsigned int active() const {
+    return m_activeHosts.size();
+  }
+  unsigned int pending() const;
+
+  // A limit of 0 means no limit.
+  unsigned int max_active() const {
+    return m_maxActive;
+  }
+  void set_max_active(unsigned int a);
+
+  unsigned int max_per_host() const {
+    return m_maxPerHost;
+  }
+  void set_max_per_host(unsigned int a);
+
+  // Lower-cased host name of the url, without user info and port.
+  static std::string url_host(const std::string& url);
+
   void set_slot_factory(slot_factory s) {
     m_slot_factory = s;
   }
@@ -58,9 +91,25 @@ public:
   }
 
 private:
+  struct pending_type {
+    iterator    itr;
+    std::string host;
+  };
+
+  using pending_list = std::list<pending_type>;
+
+  void start_pending();
+
   slot_factory    m_slot_factory;
   signal_curl_get m_signal_insert;
   signal_curl_get m_signal_erase;
+
+  unsigned int m_maxActive{ 16 };
+  unsigned int m_maxPerHost{ 4 };
+
+  pending_list                                  m_pending[priority_size];
+  std::unordered_map<CurlGet*, std::string>     m_activeHosts;
+  std::unordered_map<std::string, unsigned int> m_hostActive;
 };
 
 }
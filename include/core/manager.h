@@ -8,6 +8,7 @@
 #include <torrent/connection_manager.h>
 #include <torrent/object.h>
 #include <torrent/utils/log_buffer.h>
+#include <torrent/utils/priority_queue_default.h>
 
 #include "core/download_list.h"
 #include "core/poll_manager.h"
@@ -47,6 +48,16 @@ public:
   DownloadStore* download_store() {
     return m_downloadStore;
   }
+  // Entries of the file status cache checked per second while pruning.
+  static constexpr size_t file_status_prune_batch = 1024;
+
+  // Starts pruning the file status cache in batches, unless already
+  // in progress.
+  void prune_file_status();
+  bool is_pruning_file_status() const {
+    return m_taskPruneFileStatus.is_queued();
+  }
+
   FileStatusCache* file_status_cache() {
     return m_fileStatusCache;
   }
@@ -124,6 +135,14 @@ public:
 
   using command_list_type = std::vector<std::string>;
 
+  // HttpQueue priority class of the downloads created from now on.
+  int http_priority() const {
+    return m_httpPriority;
+  }
+  void set_http_priority(int p) {
+    m_httpPriority = p;
+  }
+
   // Temporary, find a better place for this.
   torrent::Object try_create_download(const std::string&       uri,
                                       int                      flags,
@@ -145,6 +164,7 @@ private:
 
   void receive_http_failed(std::string msg);
   void receive_hashing_changed();
+  void receive_prune_file_status();
 
   DownloadList*    m_downloadList;
   DownloadStore*   m_downloadStore;
@@ -153,12 +173,15 @@ private:
   CurlStack*       m_httpStack;
 
   View* m_hashingView{ nullptr };
+  int   m_httpPriority{ 0 };
 
   ThrottleMap        m_throttles;
   AddressThrottleMap m_addressThrottles;
 
   torrent::log_buffer_ptr m_log_important;
   torrent::log_buffer_ptr m_log_complete;
+
+  torrent::utils::priority_item m_taskPruneFileStatus;
 };
 
 // Meh, cleanup.
@@ -0,0 +1,96 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+// Copyright (C) 2021, Contributors to the rTorrent project
+
+// Reads and decodes the files of session torrents on a pool of worker
+// threads, handing the entries back in their original order so that
+// creating the downloads can stay on the main thread.
+
+#ifndef RTORRENT_CORE_SESSION_LOADER_H
+#define RTORRENT_CORE_SESSION_LOADER_H
+
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <torrent/object.h>
+
+namespace core {
+
+struct SessionEntry {
+  std::string path;
+  std::string error;
+
+  std::unique_ptr<torrent::Object> object;
+
+  // Left as TYPE_NONE if the file is missing or could not be decoded.
+  torrent::Object rtorrent;
+  torrent::Object resume;
+};
+
+class SessionSnapshot;
+
+class SessionLoader {
+public:
+  using path_list = std::vector<std::string>;
+
+  static constexpr unsigned int max_threads = 8;
+
+  // Number of entries the workers may decode ahead of the consumer,
+  // bounding the memory held by decoded but uncommitted torrents.
+  static constexpr unsigned int max_pending = 256;
+
+  // A thread count of 0 picks one based on the hardware concurrency.
+  // Sections found in 'snapshot' take precedence over the files next
+  // to the torrent.
+  SessionLoader(path_list              paths,
+                unsigned int           threads  = 0,
+                const SessionSnapshot* snapshot = nullptr);
+  ~SessionLoader();
+
+  unsigned int threads() const {
+    return m_threads.size();
+  }
+
+  // Blocks until the next entry in order has been read. Returns false
+  // once all entries have been handed out.
+  bool next(SessionEntry* entry);
+
+  // Stops the workers, dropping any entries not yet handed out.
+  void stop();
+
+  // Time spent reading and decoding summed over all workers, and time
+  // the consumer spent blocked in next().
+  double read_seconds() const;
+  double wait_seconds() const {
+    return m_waitSeconds;
+  }
+
+  static void read_entry(SessionEntry*          entry,
+                         const SessionSnapshot* snapshot = nullptr);
+
+private:
+  void run();
+
+  std::vector<SessionEntry> m_entries;
+  std::vector<char>         m_ready;
+  std::vector<std::thread>  m_threads;
+
+  const SessionSnapshot* m_snapshot;
+
+  mutable std::mutex      m_mutex;
+  std::condition_variable m_condition;
+
+  size_t m_nextRead{ 0 };
+  size_t m_nextCommit{ 0 };
+  bool   m_stop{ false };
+
+  double m_readSeconds{ 0.0 };
+  double m_waitSeconds{ 0.0 };
+};
+
+}
+
+#endif
@@ -0,0 +1,115 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+// Copyright (C) 2021, Contributors to the rTorrent project
+
+// SessionSnapshot keeps the 'rtorrent' and 'libtorrent_resume'
+// sections of all session torrents in a single append-only file.
+//
+// Each save appends a record holding both sections, and removing a
+// torrent appends an empty record. The file is replayed on open to
+// build the index, and rewritten with only the live records once the
+// superseded ones take up most of it.
+
+#ifndef RTORRENT_CORE_SESSION_SNAPSHOT_H
+#define RTORRENT_CORE_SESSION_SNAPSHOT_H
+
+#include <cstdint>
+#include <shared_mutex>
+#include <string>
+#include <unordered_map>
+
+#include <torrent/object.h>
+
+namespace core {
+
+class SessionSnapshot {
+public:
+  // Records are keyed by the hex info-hash used for the session file
+  // names.
+  static constexpr unsigned int id_size = 40;
+
+  static constexpr uint32_t record_magic = 0x31535452; // "RTS1"
+
+  struct record_header {
+    uint32_t magic;
+    uint32_t length;
+    uint32_t checksum;
+    uint32_t reserved;
+    char     id[id_size];
+  };
+
+  // Don't compact until this much of the file is superseded records.
+  static constexpr uint64_t compact_min_dead = 1 << 20;
+
+  SessionSnapshot() = default;
+  ~SessionSnapshot();
+
+  SessionSnapshot(const SessionSnapshot&) = delete;
+  SessionSnapshot& operator=(const SessionSnapshot&) = delete;
+
+  bool is_open() const {
+    return m_fd != -1;
+  }
+
+  const std::string& path() const {
+    return m_path;
+  }
+
+  // Replays the file, cutting off any incomplete or corrupt record at
+  // the end left by a crash during a save.
+  void open(const std::string& path);
+  void close();
+
+  // May be called from several threads at once.
+  bool has(const std::string& id) const;
+  bool find(const std::string& id,
+            torrent::Object*   rtorrent,
+            torrent::Object*   resume) const;
+
+  bool write(const std::string&     id,
+             const torrent::Object& rtorrent,
+             const torrent::Object& resume);
+  bool erase(const std::string& id);
+
+  // Flushes the records appended since the last call to disk.
+  bool sync();
+
+  bool needs_compaction() const;
+  bool compact();
+
+  size_t size() const;
+  uint64_t file_size() const;
+  uint64_t live_size() const;
+
+private:
+  struct entry_type {
+    uint64_t offset;
+    uint32_t length;
+  };
+
+  using index_type = std::unordered_map<std::string, entry_type>;
+
+  void     map_file();
+  void     unmap_file();
+  bool     replay();
+  bool     append(const std::string& id, const std::string& payload);
+  bool     read_payload(const entry_type& entry, std::string* payload) const;
+  uint32_t checksum(const record_header& header, const char* payload) const;
+
+  mutable std::shared_mutex m_mutex;
+
+  std::string m_path;
+  int         m_fd{ -1 };
+
+  // The file as it was when opened or compacted. Records appended
+  // after that are read with pread().
+  const char* m_map{ nullptr };
+  uint64_t    m_mapSize{ 0 };
+
+  index_type m_index;
+  uint64_t   m_fileSize{ 0 };
+  uint64_t   m_liveSize{ 0 };
+};
+
+}
+
+#endif
@@ -0,0 +1,87 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+// Copyright (C) 2021, Contributors to the rTorrent project
+
+#ifndef RTORRENT_CORE_SESSION_WRITER_H
+#define RTORRENT_CORE_SESSION_WRITER_H
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_set>
+
+namespace core {
+
+// Thread serializing and writing session files, so the main thread
+// only has to copy the sections to save. Jobs run in the order they
+// were pushed.
+class SessionWriter {
+public:
+  using job_type = std::function<bool()>;
+
+  // Pushing blocks while the queued jobs hold more than this.
+  static constexpr size_t max_queued_bytes = 64 << 20;
+
+  SessionWriter() = default;
+  ~SessionWriter();
+
+  SessionWriter(const SessionWriter&) = delete;
+  SessionWriter& operator=(const SessionWriter&) = delete;
+
+  bool is_running() const {
+    return m_thread.joinable();
+  }
+
+  // Set while there are jobs queued or being run.
+  bool is_busy() const {
+    return m_busy != 0;
+  }
+
+  void start();
+
+  // Finishes the queued jobs and joins the thread.
+  void stop();
+
+  // Runs the job on the calling thread if the writer isn't running.
+  // 'bytes' is an estimate of the memory held by the job, and 'id' is
+  // remembered if the job fails.
+  void push(const std::string& id, size_t bytes, job_type job);
+
+  // Returns true once for each failed job for 'id'.
+  bool take_failed(const std::string& id);
+
+  // Jobs that failed since startup, each also logged as an error.
+  uint64_t failed_jobs() const {
+    return m_failedJobs;
+  }
+
+private:
+  struct entry_type {
+    std::string id;
+    size_t      bytes;
+    job_type    job;
+  };
+
+  void run();
+  void finished(const std::string& id, bool success);
+
+  std::atomic<unsigned int> m_busy{ 0 };
+  std::atomic<uint64_t>     m_failedJobs{ 0 };
+
+  std::mutex                      m_lock;
+  std::condition_variable         m_condition;
+  std::condition_variable         m_drained;
+  std::deque<entry_type>          m_jobs;
+  size_t                          m_queuedBytes{ 0 };
+  bool                            m_stop{ false };
+  std::unordered_set<std::string> m_failed;
+  std::thread                     m_thread;
+};
+
+}
+
+#endif
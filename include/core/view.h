@@ -18,18 +18,65 @@
 
 #include <functional>
 #include <list>
+#include <memory>
 #include <string>
+#include <unordered_map>
 #include <vector>
 
 #include <torrent/object.h>
 #include <torrent/utils/timer.h>
 
 #include "globals.h"
+#include "rpc/command.h"
+
+namespace rpc {
+struct parsed_command;
+}
 
 namespace core {
 
 class Download;
 
+// A sort or filter command, resolved against the command map when
+// first called instead of being parsed for every download. It is
+// resolved again if commands have been erased since.
+class ViewCommand {
+public:
+  enum sort_type { sort_none, sort_less, sort_greater };
+
+  ViewCommand();
+  ~ViewCommand();
+  ViewCommand(const ViewCommand&) = delete;
+  void operator=(const ViewCommand&) = delete;
+
+  bool is_empty() const {
+    return m_object.is_empty();
+  }
+
+  const torrent::Object& object() const {
+    return m_object;
+  }
+  void set(const torrent::Object& cmd);
+
+  // Throws torrent::input_error if the command can't be resolved.
+  torrent::Object call(rpc::target_type target) const;
+
+  // Set if the command is a 'less' or 'greater' on a single getter,
+  // which allows sorting on keys called once for each download.
+  sort_type sort_order() const;
+  torrent::Object call_sort_key(Download* download) const;
+
+private:
+  void resolve() const;
+
+  torrent::Object m_object;
+
+  mutable std::unique_ptr<rpc::parsed_command> m_command;
+  mutable std::unique_ptr<rpc::parsed_command> m_sortKey;
+  mutable sort_type                            m_sortOrder{ sort_none };
+  mutable uint64_t                             m_generation{ 0 };
+};
+
 class View : private std::vector<Download*> {
 public:
   using base_type   = std::vector<Download*>;
@@ -108,8 +155,13 @@ public:
     emit_changed();
   }
 
+  bool is_visible(Download* download) const {
+    auto itr = m_index.find(download);
+    return itr != m_index.end() && itr->second.visible;
+  }
+
   void insert(Download* download) {
-    base_type::push_back(download);
+    push_filtered(download, m_index[download]);
   }
   void erase(Download* download);
 
@@ -121,29 +173,40 @@ public:
 
   void sort();
 
-  void set_sort_new(const torrent::Object& s) {
-    m_sortNew = s;
-  }
+  void set_sort_new(const torrent::Object& s);
   void set_sort_current(const torrent::Object& s) {
-    m_sortCurrent = s;
+    m_sortCurrent.set(s);
   }
 
   // Need to explicity trigger filtering.
   void filter();
+  // Filters and sorts all downloads.
+  void refresh();
   void filter_by(const torrent::Object& condition, base_type& result);
   void filter_download(core::Download* download);
 
+  // Queues the download to be filtered and placed again. Downloads
+  // marked within a scheduler tick are handled in a single pass by
+  // update_dirty(), which only moves visible downloads if the view is
+  // in the order of 'm_sortNew'.
+  void mark_dirty(Download* download);
+  void update_dirty();
+
+  size_type size_dirty() const {
+    return m_dirty.size();
+  }
+
   const torrent::Object& get_filter() const {
-    return m_filter;
+    return m_filter.object();
   }
   void set_filter(const torrent::Object& s) {
-    m_filter = s;
+    m_filter.set(s);
   }
   const torrent::Object& get_filter_temp() const {
-    return m_temp_filter;
+    return m_temp_filter.object();
   }
   void set_filter_temp(const torrent::Object& s) {
-    m_temp_filter = s;
+    m_temp_filter.set(s);
   }
   void set_filter_on_event(const std::string& event);
 
@@ -175,6 +238,11 @@ public:
     m_lastChanged = t;
   }
 
+  // The time of the last call to refresh().
+  torrent::utils::timer last_refresh() const {
+    return m_lastRefresh;
+  }
+
   // Don't connect any slots until after initialize else it get's
   // triggered when adding the Download's in DownloadList.
   signal_void& signal_changed() {
@@ -182,13 +250,48 @@ public:
   }
 
 private:
+  // Whether a download is visible, and the 'm_sortNew' key it was last
+  // placed by, so finding and placing downloads doesn't have to call
+  // the sort command on every other download. Filtered downloads are
+  // numbered in increasing order along the filtered part.
+  struct index_entry {
+    bool            visible{ false };
+    bool            dirty{ false };
+    uint64_t        sequence{ 0 };
+    torrent::Object key;
+  };
+
+  using index_type = std::unordered_map<Download*, index_entry>;
+
   void push_back(Download* d) {
     base_type::push_back(d);
   }
 
-  inline void insert_visible(Download* d);
+  inline void insert_visible(Download* d, torrent::Object key);
+  void        push_filtered(Download* d, index_entry& entry);
   inline void erase_internal(iterator itr);
 
+  iterator find_visible(Download* d);
+  iterator find_filtered(Download* d);
+
+  const torrent::Object& cached_key(Download* d) const {
+    return m_index.find(d)->second.key;
+  }
+  uint64_t sequence(Download* d) const {
+    return m_index.find(d)->second.sequence;
+  }
+  void update_sorted_by_key();
+
+  bool sort_by_key(const ViewCommand& cmd, bool store_keys);
+
+  // The 'started' and 'stopped' views are only changed explicitly.
+  bool is_filter_fixed() const {
+    return m_name == "started" || m_name == "stopped";
+  }
+
+  bool refilter_download(Download* download, bool place_unsorted);
+  void clear_dirty();
+
   void emit_changed();
   void emit_changed_now();
 
@@ -203,18 +306,27 @@ private:
   size_type m_size;
   size_type m_focus;
 
-  // These should be replaced by a faster non-string command type.
-  torrent::Object m_sortNew;
-  torrent::Object m_sortCurrent;
+  index_type m_index;
+  uint64_t   m_sequence{ 0 };
+
+  // Set while the visible downloads are in the order of their cached
+  // keys, allowing binary searches on them.
+  bool m_sortedByKey{ false };
 
-  torrent::Object m_filter;
-  torrent::Object
-    m_temp_filter; // Temporary view filter (eg: name based filter)
+  ViewCommand m_sortNew;
+  ViewCommand m_sortCurrent;
+
+  ViewCommand m_filter;
+  ViewCommand m_temp_filter; // Temporary view filter (eg: name based filter)
 
   torrent::Object m_event_added;
   torrent::Object m_event_removed;
 
   torrent::utils::timer m_lastChanged;
+  torrent::utils::timer m_lastRefresh;
+
+  base_type                     m_dirty;
+  torrent::utils::priority_item m_delayDirty;
 
   signal_void                   m_signal_changed;
   torrent::utils::priority_item m_delayChanged;
@@ -57,9 +57,26 @@ public:
   // If View::last_changed() is less than 'timeout' seconds ago, don't
   // sort.
   //
+  // With a 'timeout' and a non-zero 'refresh_interval', only the
+  // downloads marked dirty are filtered and sorted until the last full
+  // pass is 'refresh_interval' seconds old. Views sorted or filtered on
+  // things that change without a download event, like ratios and
+  // transfer rates, are only updated by the full pass, so the default
+  // of 0 always does one.
+  //
   // Find a better name for 'timeout'.
   void sort(const std::string& name, uint32_t timeout = 0);
 
+  // Marks the download dirty in all views.
+  void mark_dirty(Download* download);
+
+  uint32_t refresh_interval() const {
+    return m_refreshInterval;
+  }
+  void set_refresh_interval(uint32_t seconds) {
+    m_refreshInterval = seconds;
+  }
+
   // These could be moved to where the command is implemented.
   void set_sort_new(const std::string& name, const torrent::Object& cmd) {
     (*find_throw(name))->set_sort_new(cmd);
@@ -78,6 +95,9 @@ public:
   void set_event_removed(const std::string& name, const torrent::Object& cmd) {
     (*find_throw(name))->set_event_removed(cmd);
   }
+
+private:
+  uint32_t m_refreshInterval{ 0 };
 };
 
 }
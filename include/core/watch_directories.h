@@ -0,0 +1,124 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+// Copyright (C) 2021, Contributors to the rTorrent project
+
+// Watches directories with inotify and reports the '.torrent' files
+// written or moved into them, without ever rescanning a directory
+// once it is watched.
+//
+// A file is reported once it has been left alone for the debounce
+// period, so a torrent written in several steps or replaced right
+// after being created is loaded only once.
+
+#ifndef RTORRENT_CORE_WATCH_DIRECTORIES_H
+#define RTORRENT_CORE_WATCH_DIRECTORIES_H
+
+#include <functional>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include <torrent/event.h>
+#include <torrent/utils/priority_queue_default.h>
+
+namespace torrent {
+class Poll;
+}
+
+namespace core {
+
+class WatchDirectories : public torrent::Event {
+public:
+  using slot_string = std::function<void(const std::string&)>;
+
+  // Also watch the subdirectories, including those created later.
+  static constexpr int flag_recursive = 0x1;
+
+  WatchDirectories();
+  ~WatchDirectories() override;
+  WatchDirectories(const WatchDirectories&) = delete;
+  void operator=(const WatchDirectories&) = delete;
+
+  const char* type_name() const override {
+    return "watch_directories";
+  }
+
+  bool is_open() const {
+    return m_fileDesc != -1;
+  }
+
+  // Events are read when 'poll', owned by the main thread, reports
+  // the descriptor readable.
+  bool open(torrent::Poll* poll);
+  void close();
+
+  // Only files added after the directory is inserted are reported,
+  // unless scan_existing() is set. A directory watched twice keeps a
+  // single root, reporting to the slot and using the flags inserted
+  // last.
+  void insert(const std::string& path, int flags, slot_string slot);
+
+  unsigned int debounce() const {
+    return m_debounce;
+  }
+  void set_debounce(unsigned int seconds) {
+    m_debounce = seconds;
+  }
+
+  // Also report the '.torrent' files already in directories inserted
+  // from now on, once.
+  bool scan_existing() const {
+    return m_scanExisting;
+  }
+  void set_scan_existing(bool v) {
+    m_scanExisting = v;
+  }
+
+  // Number of directories watched and of files waiting to be reported.
+  size_t size() const {
+    return m_watches.size();
+  }
+  size_t pending() const {
+    return m_pending.size();
+  }
+
+  static bool is_torrent_file(const std::string& name);
+
+private:
+  struct root_type {
+    std::string path;
+    int         flags;
+    slot_string slot;
+  };
+
+  struct watch_type {
+    std::string path;
+    size_t      root;
+  };
+
+  struct pending_type {
+    torrent::utils::timer deadline;
+    size_t                root;
+  };
+
+  void event_read() override;
+  void event_write() override;
+  void event_error() override;
+
+  bool add_directory(const std::string& path, size_t root, bool scan);
+  void queue(const std::string& path, size_t root);
+  void receive_debounce();
+
+  torrent::Poll* m_poll{ nullptr };
+  unsigned int   m_debounce{ 1 };
+  bool           m_scanExisting{ false };
+
+  std::vector<root_type>                        m_roots;
+  std::unordered_map<int, watch_type>           m_watches;
+  std::unordered_map<std::string, pending_type> m_pending;
+
+  torrent::utils::priority_item m_taskDebounce;
+};
+
+}
+
+#endif
@@ -155,7 +155,9 @@ public:
     return *(current_stack.begin() + index);
   }
 
-  static stack_type current_stack;
+  // Each thread executing commands, such as the RPC workers, keeps
+  // its own argument stack.
+  static thread_local stack_type current_stack;
 
   static torrent::Object* stack_begin() {
     return current_stack.begin();
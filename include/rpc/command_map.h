@@ -4,9 +4,11 @@
 #ifndef RTORRENT_RPC_COMMAND_MAP_H
 #define RTORRENT_RPC_COMMAND_MAP_H
 
+#include <cstdint>
 #include <cstring>
 #include <map>
 #include <string>
+#include <vector>
 
 #include <torrent/object.h>
 
@@ -60,7 +62,6 @@ public:
 
   using base_type::begin;
   using base_type::end;
-  using base_type::find;
 
   static constexpr int flag_dont_delete   = 0x1;
   static constexpr int flag_delete_key    = 0x2;
@@ -78,13 +79,24 @@ public:
   CommandMap(const CommandMap&) = delete;
   void operator=(const CommandMap&) = delete;
 
+  // Lookups use a hash index of the keys, the map itself keeps the
+  // commands ordered for listing.
+  iterator       find(const char* key);
+  const_iterator find(const char* key) const;
+
   bool has(const char* key) const {
-    return base_type::find(key) != base_type::end();
+    return find(key) != end();
   }
   bool has(const std::string& key) const {
     return has(key.c_str());
   }
 
+  // Changes whenever a command is erased, so holders of iterators know
+  // to look the command up again.
+  uint64_t generation() const {
+    return m_generation;
+  }
+
   bool is_modifiable(const_iterator itr) {
     return itr != end() && (itr->second.m_flags & flag_modifiable);
   }
@@ -160,6 +172,24 @@ public:
     return call_command(
       key, arg, target_type((int)command_base::target_file, file, nullptr));
   }
+
+private:
+  // Open addressing with linear probing, sized to a power of two at
+  // least twice the number of commands.
+  struct index_entry {
+    size_t   hash;
+    iterator itr;
+    bool     used;
+  };
+
+  static size_t hash_key(const char* key);
+
+  const index_entry* index_find(const char* key) const;
+  void               index_insert(iterator itr);
+  void               index_erase(iterator itr);
+
+  std::vector<index_entry> m_index;
+  uint64_t                 m_generation{ 0 };
 };
 
 inline target_type
@@ -0,0 +1,160 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+// Copyright (C) 2021, Contributors to the rTorrent project
+
+// EventBus batches download events for the websocket subscribers.
+//
+// Events are pushed by the main thread into a ring, and a flush every
+// 'flush_interval' milliseconds hands them over to the websocket loop.
+// The loop serializes each topic's events into a single frame whose
+// 'result' is the list of events, reusing the buffers between flushes.
+//
+// Each event is published to these topics, skipping those without
+// subscribers:
+//
+//   event.*                 All events.
+//   event.download.<name>   Events with that name.
+//   hash.<info-hash>        Events of the download, in upper case hex.
+//   view.<name>             Events of downloads visible in the view.
+
+#ifndef RTORRENT_RPC_EVENT_BUS_H
+#define RTORRENT_RPC_EVENT_BUS_H
+
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include <torrent/hash_string.h>
+#include <torrent/utils/priority_queue_default.h>
+
+namespace rpc {
+
+class EventBus {
+public:
+  using defer_slot   = std::function<void(std::function<void()>)>;
+  using publish_slot = std::function<void(std::string_view, std::string_view)>;
+
+  using view_list = std::vector<std::string>;
+
+  static constexpr uint32_t ring_size = 1 << 14;
+
+  // Views past this index can't be subscribed to.
+  static constexpr unsigned int max_views = 64;
+
+  EventBus();
+  ~EventBus();
+
+  EventBus(const EventBus&) = delete;
+  EventBus& operator=(const EventBus&) = delete;
+
+  bool is_open() const {
+    return m_open.load(std::memory_order_acquire);
+  }
+
+  // Called by the loop thread once it runs. 'defer' must queue its
+  // argument to be called on the loop, and 'publish' is only called
+  // from there.
+  void open(defer_slot defer, publish_slot publish);
+
+  // Called from the main thread before the loop stops. Events not yet
+  // handed to the loop are dropped.
+  void close();
+
+  uint32_t flush_interval() const {
+    return m_flushInterval;
+  }
+  void set_flush_interval(uint32_t ms) {
+    m_flushInterval = ms;
+  }
+
+  // Events pushed while closed are dropped. The event name must be a
+  // string literal, as only the pointer is queued. Bit 'i' of 'views'
+  // is set if the download is visible in the i'th view of the list
+  // last passed to set_views().
+  void push(const torrent::HashString& hash,
+            const char*                event,
+            uint64_t                   views = 0);
+
+  // Set while any view topic has subscribers, else there is no need
+  // to find the views of a download.
+  bool has_view_subscribers() const {
+    return m_viewSubscribers.load(std::memory_order_relaxed) != 0;
+  }
+
+  size_t view_count() const {
+    return m_views->size();
+  }
+  // Views may only be appended to the list.
+  void set_views(view_list views) {
+    m_views = std::make_shared<const view_list>(std::move(views));
+  }
+
+  // Moves the queued events to the ring and has the loop drain it.
+  // Called by the flush task, only from the main thread.
+  void flush();
+
+  // Events waiting in the ring or, if it was full, on the main thread.
+  size_t pending() const;
+
+  // Returns the topic in canonical form, or an empty string if it
+  // isn't one of the topics above.
+  static std::string normalize_topic(const std::string& topic);
+
+  // Called from the loop for each subscriber of a normalized topic.
+  void subscribe(const std::string& topic);
+  void unsubscribe(const std::string& topic);
+
+private:
+  struct event_type {
+    const char*         event;
+    torrent::HashString hash;
+    int64_t             timestamp;
+    uint64_t            views;
+  };
+
+  using count_map  = std::unordered_map<std::string, unsigned int>;
+  using buffer_map = std::unordered_map<std::string, std::string>;
+
+  bool push_ring(const event_type& event);
+  void drain(const view_list& views);
+  void append(const std::string& topic);
+
+  std::atomic<bool> m_open{ false };
+  defer_slot        m_defer;
+  publish_slot      m_publish;
+
+  uint32_t                      m_flushInterval{ 100 };
+  torrent::utils::priority_item m_taskFlush;
+
+  // Single producer (the main thread) and consumer (the loop) ring.
+  std::unique_ptr<event_type[]> m_ring;
+  std::atomic<uint32_t>         m_ringHead{ 0 };
+  std::atomic<uint32_t>         m_ringTail{ 0 };
+  std::atomic<bool>             m_draining{ false };
+
+  // Events that didn't fit in the ring, kept in order until there is
+  // room again.
+  std::vector<event_type> m_overflow;
+
+  // Handed to the loop with each drain.
+  std::shared_ptr<const view_list> m_views{ std::make_shared<view_list>() };
+
+  std::atomic<unsigned int> m_viewSubscribers{ 0 };
+
+  // Only used by the loop. Buffers of topics that lose their last
+  // subscriber are released.
+  count_map    m_subscribers;
+  unsigned int m_hashSubscribers{ 0 };
+  buffer_map   m_buffers;
+  std::string  m_event;
+  std::string  m_topic;
+};
+
+}
+
+#endif
@@ -6,6 +6,7 @@
 
 #include <cstring>
 #include <string>
+#include <vector>
 
 #include "rpc/command_map.h"
 #include "rpc/exec_file.h"
@@ -34,6 +35,31 @@ parse_command_multiple(target_type target, const char* first, const char* last);
 void
 parse_command_execute(target_type target, torrent::Object* object);
 
+// A single command that has been parsed and resolved against the
+// command map, so it can be called on many targets without parsing
+// the string and searching the map each time.
+struct parsed_command {
+  // Points to 'commands.end()' for an empty or commented-out command.
+  CommandMap::iterator itr;
+  torrent::Object      args;
+
+  // Set if the arguments contain '$' strings or function objects that
+  // must be re-evaluated for every target.
+  bool execute{ false };
+};
+
+using parsed_command_list = std::vector<parsed_command>;
+
+parsed_command
+parse_command_compile(const char* first, const char* last);
+torrent::Object
+call_parsed_command(const parsed_command& cmd, target_type target);
+
+inline parsed_command
+parse_command_compile(const std::string& cmd) {
+  return parse_command_compile(cmd.c_str(), cmd.c_str() + cmd.size());
+}
+
 inline torrent::Object
 parse_command_single(target_type target, const char* first) {
   return parse_command(target, first, first + std::strlen(first)).first;
@@ -6,6 +6,7 @@
 
 #include <cstdint>
 #include <functional>
+#include <string>
 
 #include <torrent/exceptions.h>
 
@@ -25,6 +26,9 @@ class IRpc {
 public:
   using res_callback = std::function<bool(const char*, uint32_t)>;
 
+  // Receives responses produced on another thread.
+  using async_callback = std::function<void(std::string&&)>;
+
   virtual void initialize() {}
 
   virtual void cleanup() {}
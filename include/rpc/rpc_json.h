@@ -7,6 +7,7 @@
 #include "buildinfo.h"
 
 #include <functional>
+#include <string>
 
 #ifdef HAVE_JSON
 #include "utils/jsonrpc/server.h"
@@ -14,11 +15,26 @@
 
 #include "rpc/rpc.h"
 
+namespace torrent {
+class Object;
+}
+
 namespace rpc {
 
+class RpcWorkerPool;
+
+#ifdef HAVE_JSON
+void
+json_write_string(const std::string& str, std::string* dest);
+void
+json_write_object(const torrent::Object& object, std::string* dest);
+#endif
+
 class RpcJson final : public IRpc {
 #ifdef HAVE_JSON
 public:
+  static constexpr size_t max_retained_buffer = 16 << 20;
+
   void initialize() override;
 
   void cleanup() override;
@@ -29,6 +45,13 @@ public:
                uint32_t     length,
                res_callback callback) override;
 
+  // Queues the request on 'pool' if every call in it is read-only,
+  // else returns false so it is processed on the calling thread.
+  bool process_readonly(const char*    inBuffer,
+                        uint32_t       length,
+                        RpcWorkerPool& pool,
+                        async_callback callback);
+
   void insert_command(const char*, const char*, const char*) override {}
 
 private:
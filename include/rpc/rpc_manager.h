@@ -11,6 +11,7 @@
 
 #include "rpc/command.h"
 #include "rpc/rpc.h"
+#include "rpc/rpc_worker_pool.h"
 
 namespace rpc {
 class RpcManager {
@@ -32,6 +33,21 @@ public:
                 uint32_t           length,
                 IRpc::res_callback callback);
 
+  // Executes read-only requests on the worker threads, with 'callback'
+  // called from the worker. Returns false if the request needs to be
+  // dispatched on the calling thread instead.
+  bool dispatch_readonly(RPCType              type,
+                         const char*          inBuffer,
+                         uint32_t             length,
+                         IRpc::async_callback callback);
+
+  unsigned int worker_threads() const {
+    return m_workers.size();
+  }
+  void set_worker_threads(unsigned int count) {
+    m_workers.resize(count);
+  }
+
   void initialize(slot_download fun_d,
                   slot_file     fun_f,
                   slot_tracker  fun_t,
@@ -61,6 +77,8 @@ private:
 
   bool m_initialized;
 
+  RpcWorkerPool m_workers;
+
   slot_download m_slotFindDownload;
   slot_file     m_slotFindFile;
   slot_tracker  m_slotFindTracker;
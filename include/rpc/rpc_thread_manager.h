@@ -29,7 +29,13 @@ public:
 
     torrent::Poll* poll();
 
+    ThreadBase::priority_queue* task_scheduler();
+
+    rpc::SCgiSender* scgi_sender();
+
     void publish_ws_topic(std::string_view topic, std::string_view message);
+
+    rpc::EventBus* event_bus();
     
 private:
 
@@ -0,0 +1,70 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+// Copyright (C) 2021, Contributors to the rTorrent project
+
+#ifndef RTORRENT_RPC_WORKER_POOL_H
+#define RTORRENT_RPC_WORKER_POOL_H
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace rpc {
+
+// Threads executing read-only RPC requests outside of the I/O loops
+// that received them. Jobs are responsible for passing their results
+// back to the owning loop.
+class RpcWorkerPool {
+public:
+  using job_type = std::function<void()>;
+
+  static constexpr unsigned int max_size = 64;
+
+  RpcWorkerPool() = default;
+  ~RpcWorkerPool();
+
+  RpcWorkerPool(const RpcWorkerPool&) = delete;
+  RpcWorkerPool& operator=(const RpcWorkerPool&) = delete;
+
+  unsigned int size() const {
+    return m_size;
+  }
+
+  // Threads started and not yet joined.
+  size_t thread_count();
+
+  // Starts or retires threads, 'count' of zero disables the pool.
+  // Retired threads exit once the queue is empty without being waited
+  // for, as the caller may hold the global lock they need. They are
+  // joined by a later call once they have exited.
+  void resize(unsigned int count);
+
+  // Drops the queued jobs and joins the threads once their current
+  // jobs return. The caller must not hold a lock those jobs wait on.
+  void stop();
+
+  // Runs the job on the calling thread if the pool isn't running.
+  void push(job_type job);
+
+private:
+  void run();
+
+  std::atomic<unsigned int> m_size{ 0 };
+
+  std::mutex               m_lock;
+  std::condition_variable  m_condition;
+  std::deque<job_type>     m_jobs;
+  std::vector<std::thread> m_threads;
+  unsigned int             m_running{ 0 };
+
+  // Threads that have returned from run() and may be joined.
+  std::vector<std::thread::id> m_exited;
+};
+
+}
+
+#endif
@@ -4,7 +4,11 @@
 #ifndef RTORRENT_RPC_SCGI_H
 #define RTORRENT_RPC_SCGI_H
 
+#include <atomic>
+#include <cstdint>
+#include <mutex>
 #include <string>
+#include <vector>
 
 #include <torrent/event.h>
 #include <torrent/utils/cacheline.h>
@@ -22,6 +26,7 @@ public:
   static constexpr int max_tasks = 100;
 
   // Global lock:
+  SCgi();
   ~SCgi() override;
 
   const char* type_name() const override {
@@ -45,12 +50,39 @@ public:
     m_logFd = fd;
   }
 
+  // Keep connections open after a response, allowing clients to send
+  // further, possibly pipelined, requests. Set before activating.
+  bool is_keep_alive() const {
+    return m_keepAlive;
+  }
+  void set_keep_alive(bool state) {
+    m_keepAlive = state;
+  }
+
+  // Seconds a persistent connection may wait for its next request
+  // before it is closed, freeing the task for new connections.
+  uint32_t keep_alive_timeout() const {
+    return m_keepAliveTimeout;
+  }
+  void set_keep_alive_timeout(uint32_t seconds) {
+    m_keepAliveTimeout = seconds;
+  }
+
+  // Connections closed because all tasks were busy.
+  uint64_t rejected() const {
+    return m_rejected;
+  }
+
   // Thread local:
   void event_read() override;
   void event_write() override;
   void event_error() override;
 
   bool receive_call(SCgiTask* task, const char* buffer, uint32_t length);
+  void release_task(SCgiTask* task);
+
+  // Writes the responses queued by the RPC worker threads.
+  void deliver_responses();
 
   static bool process_and_send(int fd, const char* data, int length, bool is_json);
 
@@ -59,11 +91,29 @@ public:
   }
 
 private:
+  struct queued_response {
+    SCgiTask*   task;
+    uint32_t    generation;
+    std::string response;
+  };
+
   void open(void* sa, unsigned int length);
 
+  // Any thread:
+  void queue_response(SCgiTask* task, uint32_t generation, std::string&& response);
+
   std::string m_path;
   int         m_logFd{ -1 };
-  SCgiTask    m_task[max_tasks];
+  bool        m_keepAlive{ false };
+  uint32_t    m_keepAliveTimeout{ 60 };
+
+  std::atomic<uint64_t> m_rejected{ 0 };
+
+  SCgiTask               m_task[max_tasks];
+  std::vector<SCgiTask*> m_freeTasks;
+
+  std::mutex                   m_responseLock;
+  std::vector<queued_response> m_responses;
 };
 
 }
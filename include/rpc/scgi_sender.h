@@ -0,0 +1,79 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+// Copyright (C) 2021, Contributors to the rTorrent project
+
+// SCgiSender finishes the responses that 'SCgi::process_and_send'
+// couldn't write at once on the websockets loop, so the loop never
+// waits for a client that doesn't read. The rest of the response is
+// kept per connection and written by the SCGI worker thread once the
+// socket becomes writable.
+//
+// The unsent data is written through a duplicate of the descriptor,
+// keeping the socket valid should the loop close the connection
+// meanwhile. Responses to later requests on the connection are
+// appended so they are sent in order, with the connection found by the
+// socket's inode as the loop may reuse the descriptor number.
+
+#ifndef RTORRENT_RPC_SCGI_SENDER_H
+#define RTORRENT_RPC_SCGI_SENDER_H
+
+#include <atomic>
+#include <mutex>
+#include <string>
+#include <sys/types.h>
+#include <sys/uio.h>
+#include <vector>
+
+#include <torrent/utils/priority_queue_default.h>
+
+class ThreadBase;
+
+namespace rpc {
+
+class SCgiSender {
+public:
+  // Milliseconds a connection may go without progress before it is
+  // shut down.
+  static constexpr int send_timeout = 30000;
+
+  SCgiSender(ThreadBase* thread);
+  ~SCgiSender();
+
+  SCgiSender(const SCgiSender&) = delete;
+  SCgiSender& operator=(const SCgiSender&) = delete;
+
+  // Called from the loop. Appends the iovec to the unsent data of the
+  // connection, returning false if there is none and it may be
+  // written directly.
+  bool append(int fd, const struct iovec* iov, int iovcnt);
+
+  // Called from the loop with the part of a response the socket didn't
+  // take. Returns false if the connection can't be taken over.
+  bool queue(int fd, const struct iovec* iov, int iovcnt);
+
+  // Connections with unsent data.
+  size_t size() const {
+    return m_size.load(std::memory_order_relaxed);
+  }
+
+  // Worker thread, polls the connections queued since the last call.
+  void open_connections();
+
+private:
+  class Connection;
+
+  // Worker thread:
+  void close_connection(Connection* connection, bool shutdown);
+  void receive_timeout();
+
+  ThreadBase* m_thread;
+
+  std::mutex               m_lock;
+  std::vector<Connection*> m_connections;
+  std::atomic<size_t>      m_size{ 0 };
+
+  torrent::utils::priority_item m_taskTimeout;
+};
+
+}
+
+#endif
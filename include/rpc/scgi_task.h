@@ -4,7 +4,10 @@
 #ifndef RTORRENT_RPC_SCGI_TASK_H
 #define RTORRENT_RPC_SCGI_TASK_H
 
+#include <string>
+
 #include <torrent/event.h>
+#include <torrent/utils/priority_queue_default.h>
 
 namespace utils {
 class SocketFd;
@@ -23,6 +26,7 @@ public:
 
   SCgiTask() {
     m_fileDesc = -1;
+    m_taskIdle.slot() = [this] { close(); };
   }
 
   ContentType type() const {
@@ -36,6 +40,12 @@ public:
     return m_fileDesc == -1;
   }
 
+  // Incremented for every connection, so responses computed on other
+  // threads can tell if the task was closed and reused meanwhile.
+  uint32_t generation() const {
+    return m_generation;
+  }
+
   void open(SCgi* parent, int fd);
   void close();
 
@@ -54,7 +64,11 @@ private:
                              const char* buffer     = nullptr,
                              uint32_t    bufferSize = 0);
 
+  void process_read();
+  void restart();
+
   ContentType m_type{ XML };
+  uint32_t    m_generation{ 0 };
 
   SCgi* m_parent;
 
@@ -63,6 +77,14 @@ private:
   char* m_body;
 
   unsigned int m_bufferSize;
+  unsigned int m_bufferCapacity;
+
+  // Data received after the end of the current request, kept for the
+  // next request on persistent connections.
+  std::string m_pipelined;
+
+  // Closes persistent connections waiting too long for a request.
+  torrent::utils::priority_item m_taskIdle;
 };
 
 }
@@ -0,0 +1,6 @@
+#include <gtest/gtest.h>
+
+class CurlStackTest : public ::testing::Test {
+public:
+  void SetUp() override;
+};
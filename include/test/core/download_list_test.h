@@ -0,0 +1,33 @@
+#include <gtest/gtest.h>
+
+#include <string>
+
+#include "core/download_list.h"
+
+class DownloadListTest : public ::testing::Test {
+protected:
+  // The downloads are never dereferenced, the list only gets their
+  // info-hashes through these helpers.
+  core::Download*     download(unsigned int i);
+  torrent::HashString hash(unsigned int i);
+  std::string         hex(unsigned int i);
+
+  void insert(unsigned int i, unsigned int hash_of);
+  void insert(unsigned int i) {
+    insert(i, i);
+  }
+
+  // Erases through an iterator found by the hash, as 'erase' callers
+  // do, or by the download, as 'erase_ptr' does.
+  void erase(unsigned int i);
+  void erase_ptr(unsigned int i, unsigned int hash_of);
+
+  core::Download* find(unsigned int i);
+  core::Download* find_hex(unsigned int i);
+
+  size_t index_size() const {
+    return m_list.m_hashIndex.size();
+  }
+
+  core::DownloadList m_list;
+};
@@ -0,0 +1,8 @@
+#include <gtest/gtest.h>
+
+#include "test/helpers/temp_directory.h"
+
+class DownloadStoreTest : public ::testing::Test {
+protected:
+  TempDirectory m_directory{ "rtorrent_store" };
+};
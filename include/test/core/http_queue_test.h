@@ -0,0 +1,24 @@
+#include <gtest/gtest.h>
+
+#include <memory>
+#include <sstream>
+
+#include "core/curl_stack.h"
+#include "core/http_queue.h"
+
+class HttpQueueTest : public ::testing::Test {
+public:
+  void SetUp() override;
+  void TearDown() override;
+
+protected:
+  core::CurlGet* insert(const std::string& url,
+                        int priority = core::HttpQueue::priority_interactive);
+  void           finish(core::CurlGet* http);
+
+  // Transfers are started on the stack but never run, as it allows no
+  // active transfers.
+  std::unique_ptr<core::CurlStack> m_stack;
+  std::stringstream                m_stream;
+  core::HttpQueue                  m_queue;
+};
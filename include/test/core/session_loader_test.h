@@ -0,0 +1,8 @@
+#include <gtest/gtest.h>
+
+#include "test/helpers/temp_directory.h"
+
+class SessionLoaderTest : public ::testing::Test {
+protected:
+  TempDirectory m_directory{ "rtorrent_session" };
+};
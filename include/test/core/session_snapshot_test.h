@@ -0,0 +1,9 @@
+#include <gtest/gtest.h>
+
+#include "test/helpers/temp_directory.h"
+
+class SessionSnapshotTest : public ::testing::Test {
+protected:
+  TempDirectory m_directory{ "rtorrent_snapshot" };
+  std::string   m_path{ m_directory.path() + "/session.snapshot" };
+};
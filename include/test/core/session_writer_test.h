@@ -0,0 +1,3 @@
+#include <gtest/gtest.h>
+
+class SessionWriterTest : public ::testing::Test {};
@@ -0,0 +1,6 @@
+#include <gtest/gtest.h>
+
+class ViewTest : public ::testing::Test {
+public:
+  void SetUp() override;
+};
@@ -0,0 +1,26 @@
+#include <gtest/gtest.h>
+
+#include <string>
+#include <vector>
+
+#include "core/watch_directories.h"
+#include "test/helpers/temp_directory.h"
+
+class WatchDirectoriesTest : public ::testing::Test {
+public:
+  void SetUp() override;
+  void TearDown() override;
+
+protected:
+  // Reads the queued inotify events, then runs the debounce task once
+  // its deadline has passed.
+  void read_events();
+  void advance(unsigned int seconds);
+
+  void write_file(const std::string& path);
+
+  TempDirectory            m_directory{ "rtorrent_watch" };
+  torrent::Poll*           m_poll{ nullptr };
+  core::WatchDirectories   m_watch;
+  std::vector<std::string> m_reported;
+};
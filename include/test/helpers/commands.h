@@ -0,0 +1,30 @@
+#ifndef HELPERS_COMMANDS_H
+#define HELPERS_COMMANDS_H
+
+#include <clocale>
+
+#include "control.h"
+#include "globals.h"
+#include "rpc/parse_commands.h"
+
+void
+initialize_command_logic();
+void
+initialize_command_dynamic();
+
+// Creates the global Control and registers the logic and dynamic
+// commands, once for the whole test binary.
+inline void
+initialize_test_commands() {
+  if (!rpc::commands.empty())
+    return;
+
+  setlocale(LC_ALL, "");
+  cachedTime = torrent::utils::timer::current();
+  control    = new Control;
+
+  initialize_command_logic();
+  initialize_command_dynamic();
+}
+
+#endif
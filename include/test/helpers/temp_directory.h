@@ -0,0 +1,33 @@
+#ifndef HELPERS_TEMP_DIRECTORY_H
+#define HELPERS_TEMP_DIRECTORY_H
+
+#include <cstdlib>
+#include <stdexcept>
+#include <string>
+
+// Directory under /tmp, removed along with its contents when the object
+// is destroyed.
+class TempDirectory {
+public:
+  TempDirectory(const std::string& prefix)
+    : m_path("/tmp/" + prefix + "_XXXXXX") {
+    if (::mkdtemp(&m_path[0]) == nullptr)
+      throw std::runtime_error("Could not create " + m_path);
+  }
+
+  ~TempDirectory() {
+    std::system(("rm -rf " + m_path).c_str());
+  }
+
+  TempDirectory(const TempDirectory&) = delete;
+  TempDirectory& operator=(const TempDirectory&) = delete;
+
+  const std::string& path() const {
+    return m_path;
+  }
+
+private:
+  std::string m_path;
+};
+
+#endif
@@ -0,0 +1,22 @@
+#include <gtest/gtest.h>
+
+#include <functional>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "rpc/event_bus.h"
+
+class EventBusTest : public ::testing::Test {
+public:
+  void SetUp() override;
+
+  // Runs the loop's side of the bus.
+  void run_deferred();
+
+  rpc::EventBus       m_bus;
+  torrent::HashString m_hash;
+
+  std::vector<std::function<void()>>               m_deferred;
+  std::vector<std::pair<std::string, std::string>> m_frames;
+};
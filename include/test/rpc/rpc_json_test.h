@@ -0,0 +1,5 @@
+#include <gtest/gtest.h>
+
+#include "rpc/rpc_json.h"
+
+class RpcJsonTest : public ::testing::Test {};
@@ -0,0 +1,5 @@
+#include <gtest/gtest.h>
+
+#include "rpc/rpc_worker_pool.h"
+
+class RpcWorkerPoolTest : public ::testing::Test {};
@@ -0,0 +1,10 @@
+#include <gtest/gtest.h>
+
+#include "test/helpers/temp_directory.h"
+#include "utils/file_status_cache.h"
+
+class FileStatusCacheTest : public ::testing::Test {
+public:
+  TempDirectory m_directory{ "rtorrent_file_status_cache" };
+  std::string   m_path{ m_directory.path() + '/' };
+};
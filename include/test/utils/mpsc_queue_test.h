@@ -0,0 +1,10 @@
+#include <gtest/gtest.h>
+
+#include <functional>
+
+#include "utils/mpsc_queue.h"
+
+class MpscQueueTest : public ::testing::Test {
+public:
+  using queue_type = utils::MpscQueue<std::function<void()>>;
+};
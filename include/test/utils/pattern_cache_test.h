@@ -0,0 +1,8 @@
+#include <gtest/gtest.h>
+
+#include "utils/pattern_cache.h"
+
+class PatternCacheTest : public ::testing::Test {
+public:
+  utils::PatternCache m_cache;
+};
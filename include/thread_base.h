@@ -4,21 +4,21 @@
 #ifndef RTORRENT_UTILS_THREAD_BASE_H
 #define RTORRENT_UTILS_THREAD_BASE_H
 
+#include <functional>
 #include <sys/types.h>
 
 #include <torrent/utils/priority_queue_default.h>
 #include <torrent/utils/thread_base.h>
 
 #include "core/poll_manager.h"
+#include "utils/mpsc_queue.h"
 
 // Move this class to libtorrent.
 
-class thread_queue_hack;
-
 class ThreadBase : public torrent::thread_base {
 public:
   using priority_queue   = torrent::utils::priority_queue_default;
-  using thread_base_func = void (*)(ThreadBase*);
+  using thread_base_func = std::function<void(ThreadBase*)>;
 
   ThreadBase();
   ~ThreadBase() override;
@@ -49,9 +49,8 @@ protected:
 
   torrent::utils::priority_item m_taskShutdown;
 
-  // Temporary hack to pass messages to a thread. This really needs to
-  // be cleaned up and/or integrated into the priority queue itself.
-  thread_queue_hack* m_threadQueue;
+  // Items queued by other threads, called from call_events().
+  utils::MpscQueue<thread_base_func> m_threadQueue;
 };
 
 #endif
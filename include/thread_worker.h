@@ -8,6 +8,7 @@
 
 #include "thread_base.h"
 #include "protocol_thread.h"
+#include "rpc/scgi_sender.h"
 
 #include <torrent/utils/cacheline.h>
 #include <torrent/utils/priority_queue_default.h>
@@ -38,9 +39,12 @@ public:
 
   static void start_protocol(ThreadBase* thread);
   static void msg_change_rpc_log(ThreadBase* thread);
+  static void msg_open_scgi_sender(ThreadBase* thread);
+  static void msg_deliver_responses(ThreadBase* thread);
 
   void queue_item(void* newFunc) override {
-    ::ThreadBase::queue_item((thread_base_func)(newFunc));
+    ::ThreadBase::queue_item(
+      reinterpret_cast<void (*)(ThreadBase*)>(newFunc));
   }
 
   torrent::Poll* poll() override {
@@ -54,6 +58,11 @@ public:
   bool is_active() const override {
     return ::ThreadBase::is_active();
   }
+
+  rpc::SCgiSender* scgi_sender() {
+    return &m_scgiSender;
+  }
+
 private:
   void task_touch_log();
 
@@ -61,6 +70,8 @@ private:
 
   std::atomic<rpc::SCgi*> lt_cacheline_aligned m_scgi{ nullptr };
 
+  rpc::SCgiSender m_scgiSender{ this };
+
 };
 
 #endif
@@ -4,47 +4,64 @@
 #ifndef RTORRENT_UTILS_FILE_STATUS_CACHE_H
 #define RTORRENT_UTILS_FILE_STATUS_CACHE_H
 
-#include <map>
+#include <cstdint>
+#include <deque>
 #include <string>
+#include <unordered_map>
+#include <vector>
 
 namespace utils {
 
-struct file_status {
-  int      m_flags;
-  uint32_t m_mtime;
-};
-
-class FileStatusCache : public std::map<std::string, file_status> {
+// Paths are split into an interned directory and the file name, which
+// is stored once in the hash index of its directory. Entries live in
+// a slot array so pruning can keep a cursor across calls while paths
+// are inserted.
+class FileStatusCache {
 public:
-  using base_type = std::map<std::string, file_status>;
+  size_t size() const {
+    return m_size;
+  }
+  bool empty() const {
+    return m_size == 0;
+  }
 
-  using base_type::const_iterator;
-  using base_type::const_reverse_iterator;
-  using base_type::iterator;
-  using base_type::reverse_iterator;
-  using base_type::value_type;
+  // Insert and return true if the entry does not exist or the new
+  // file's mtime is more recent.
+  bool insert(const std::string& path, bool shouldThrow = false);
 
-  using base_type::begin;
-  using base_type::end;
-  using base_type::rbegin;
-  using base_type::rend;
+  // Checks up to 'count' entries from where the last call stopped,
+  // dropping those that no longer point to a file or have a different
+  // mtime. Returns true once a pass over all entries is complete.
+  bool prune_step(size_t count);
 
-  using base_type::empty;
-  using base_type::size;
+  // Prunes all entries at once.
+  void prune();
 
-  using base_type::erase;
+private:
+  using file_map = std::unordered_map<std::string, uint32_t>;
 
-  //  static int flag_
+  struct directory_type {
+    std::string path;
+    file_map    files;
+  };
 
-  // Insert and return true if the entry does not exist or the new
-  // file's mtime is more recent.
-  bool insert(const std::string& path, bool shouldThrow = false);
+  // A null 'name' marks an unused slot.
+  struct entry_type {
+    const std::string* name;
+    uint32_t           directory;
+    uint32_t           mtime;
+  };
 
-  // Add a function for pruning a sorted list of paths.
+  uint32_t directory_id(const std::string& path);
+  void     erase_entry(uint32_t index);
 
-  // Function for pruning entries that no longer points to a file, or
-  // has a different mtime.
-  void prune();
+  std::deque<directory_type>                m_directories;
+  std::unordered_map<std::string, uint32_t> m_directoryIndex;
+
+  std::vector<entry_type> m_entries;
+  std::vector<uint32_t>   m_free;
+  size_t                  m_size{ 0 };
+  size_t                  m_cursor{ 0 };
 };
 
 }
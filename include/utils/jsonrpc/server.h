@@ -16,45 +16,82 @@
 namespace jsonrpccxx {
 class JsonRpcServer {
 public:
-  using JsonRpcHandler =
-    std::function<json(const std::string& name, const json& params)>;
+  // Appends the JSON text of the result to 'result'.
+  using JsonRpcHandler = std::function<
+    void(const std::string& name, const json& params, std::string& result)>;
 
-  JsonRpcServer(JsonRpcHandler handler)
-    : m_handler(handler) {}
-  virtual ~JsonRpcServer()                                           = default;
-  virtual std::string HandleRequest(const std::string_view& request) = 0;
+  // Called once for each batch array with the parsed requests and a
+  // function that processes all of them, allowing the whole batch to
+  // be executed under a single lock.
+  using JsonRpcBatchHandler = std::function<void(
+    const json& requests, const std::function<void()>& process)>;
+
+  JsonRpcServer(JsonRpcHandler handler, JsonRpcBatchHandler batchHandler)
+    : m_handler(handler)
+    , m_batchHandler(batchHandler) {}
+  virtual ~JsonRpcServer() = default;
+
+  // Writes the response into 'response', reusing its capacity.
+  virtual void HandleRequest(const std::string_view& request,
+                             std::string&            response) = 0;
 
 protected:
-  JsonRpcHandler m_handler;
+  JsonRpcHandler      m_handler;
+  JsonRpcBatchHandler m_batchHandler;
 };
 
 class JsonRpc2Server : public JsonRpcServer {
 public:
-  JsonRpc2Server(JsonRpcHandler handler)
-    : JsonRpcServer(handler) {}
+  JsonRpc2Server(JsonRpcHandler      handler,
+                 JsonRpcBatchHandler batchHandler = JsonRpcBatchHandler())
+    : JsonRpcServer(handler, batchHandler) {}
   ~JsonRpc2Server() override = default;
 
-  std::string HandleRequest(const std::string_view& requestString) override {
+  void HandleRequest(const std::string_view& requestString,
+                     std::string&            response) override {
+    json request;
+    try {
+      request = json::parse(requestString);
+    } catch (json::parse_error& e) {
+      response = json{
+        { "id", nullptr },
+        { "error",
+          { { "code", -32700 },
+            { "message", std::string("parse error: ") + e.what() } } },
+        { "jsonrpc", "2.0" }
+      }.dump();
+      return;
+    }
+    HandleParsedRequest(request, response);
+  }
+
+  // Handles a request that was already parsed, e.g. by a thread that
+  // needed to inspect it before dispatching.
+  void HandleParsedRequest(json& request, std::string& response) {
+    response.clear();
     try {
-      json request = json::parse(requestString);
       if (request.is_array()) {
-        json result = json::array();
-        for (json& r : request) {
-          json res = this->HandleSingleRequest(r);
-          if (!res.is_null()) {
-            result.push_back(std::move(res));
+        auto process = [this, &request, &response]() {
+          bool first = true;
+          response.push_back('[');
+          for (json& r : request) {
+            if (!first) {
+              response.push_back(',');
+            }
+            this->HandleSingleRequest(r, response);
+            first = false;
           }
-        }
-        return result.dump(-1, ' ', false, json::error_handler_t::replace);
-      } else if (request.is_object()) {
-        json res = HandleSingleRequest(request);
-        if (!res.is_null()) {
-          return res.dump(-1, ' ', false, json::error_handler_t::replace);
+          response.push_back(']');
+        };
+        if (m_batchHandler) {
+          m_batchHandler(request, process);
         } else {
-          return "";
+          process();
         }
+      } else if (request.is_object()) {
+        HandleSingleRequest(request, response);
       } else {
-        return json{
+        response = json{
           { "id", nullptr },
           { "error",
             { { "code", -32600 },
@@ -62,16 +99,8 @@ public:
           { "jsonrpc", "2.0" }
         }.dump();
       }
-    } catch (json::parse_error& e) {
-      return json{
-        { "id", nullptr },
-        { "error",
-          { { "code", -32700 },
-            { "message", std::string("parse error: ") + e.what() } } },
-        { "jsonrpc", "2.0" }
-      }.dump();
     } catch (json::exception& e) {
-      return json{
+      response = json{
         { "id", nullptr },
         { "error",
           { { "code", -32700 },
@@ -82,38 +111,50 @@ public:
   }
 
 private:
-  json HandleSingleRequest(json& request) {
+  static void AppendJson(const json& value, std::string& response) {
+    response += value.dump(-1, ' ', false, json::error_handler_t::replace);
+  }
+
+  void HandleSingleRequest(json& request, std::string& response) {
     json id = nullptr;
     if (valid_id(request)) {
       id = request["id"];
     }
+    // Discard any partially written result on failure.
+    const auto mark = response.size();
     try {
-      return ProcessSingleRequest(request);
+      ProcessSingleRequest(request, response);
     } catch (JsonRpcException& e) {
       json error = { { "code", e.Code() }, { "message", e.Message() } };
       if (!e.Data().is_null()) {
         error["data"] = e.Data();
       }
-      return json{ { "id", id }, { "error", error }, { "jsonrpc", "2.0" } };
+      response.resize(mark);
+      AppendJson(json{ { "id", id }, { "error", error }, { "jsonrpc", "2.0" } },
+                 response);
     } catch (std::exception& e) {
-      return json{
-        { "id", id },
-        { "error",
-          { { "code", -32603 },
-            { "message",
-              std::string("internal server error: ") + e.what() } } },
-        { "jsonrpc", "2.0" }
-      };
+      response.resize(mark);
+      AppendJson(
+        json{ { "id", id },
+              { "error",
+                { { "code", -32603 },
+                  { "message",
+                    std::string("internal server error: ") + e.what() } } },
+              { "jsonrpc", "2.0" } },
+        response);
     } catch (...) {
-      return json{ { "id", id },
-                   { "error",
-                     { { "code", -32603 },
-                       { "message", std::string("internal server error") } } },
-                   { "jsonrpc", "2.0" } };
+      response.resize(mark);
+      AppendJson(
+        json{ { "id", id },
+              { "error",
+                { { "code", -32603 },
+                  { "message", std::string("internal server error") } } },
+              { "jsonrpc", "2.0" } },
+        response);
     }
   }
 
-  json ProcessSingleRequest(json& request) {
+  void ProcessSingleRequest(json& request, std::string& response) {
     if (!has_key_type(request, "jsonrpc", json::value_t::string) ||
         request["jsonrpc"] != "2.0") {
       throw JsonRpcException(
@@ -139,11 +180,12 @@ private:
       request["params"] = json::array();
     }
 
-    const auto& result = m_handler(request["method"], request["params"]);
-
-    return { { "jsonrpc", "2.0" },
-             { "id", request["id"] },
-             { "result", result } };
+    // Keys are written in the same order 'json::dump' sorts them.
+    response += "{\"id\":";
+    AppendJson(request["id"], response);
+    response += ",\"jsonrpc\":\"2.0\",\"result\":";
+    m_handler(request["method"], request["params"], response);
+    response.push_back('}');
   }
 };
 }
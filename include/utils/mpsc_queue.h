@@ -0,0 +1,107 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+// Copyright (C) 2021, Contributors to the rTorrent project
+
+#ifndef RTORRENT_UTILS_MPSC_QUEUE_H
+#define RTORRENT_UTILS_MPSC_QUEUE_H
+
+#include <atomic>
+#include <cstddef>
+#include <utility>
+
+#include <torrent/utils/cacheline.h>
+
+namespace utils {
+
+// Unbounded multi-producer single-consumer queue. Pushing takes a
+// single atomic exchange and never blocks or fails, while only one
+// thread at a time may consume.
+//
+// Each value is held in a node linked after the previous head. A push
+// that has swapped the head but not yet linked its node hides the
+// values pushed after it, so the consumer may stop short and has to
+// be woken again by the producer once done pushing.
+template<typename T>
+class MpscQueue {
+public:
+  MpscQueue() = default;
+  ~MpscQueue();
+
+  MpscQueue(const MpscQueue&) = delete;
+  MpscQueue& operator=(const MpscQueue&) = delete;
+
+  // May be called from any thread.
+  void push(T value);
+
+  // Only to be called by the consumer.
+  bool empty() const {
+    return m_tail->next.load(std::memory_order_acquire) == nullptr;
+  }
+
+  // Calls 'func' with each value pushed before the call, and returns
+  // the number of values consumed. Values pushed by 'func' are left
+  // for the next call. If 'func' throws, the values after the one
+  // being handled stay in the queue.
+  template<typename Func>
+  size_t consume(Func func);
+
+private:
+  struct node_type {
+    T                       value;
+    std::atomic<node_type*> next{ nullptr };
+  };
+
+  // The consumer owns 'm_tail', whose value has already been taken.
+  // It starts out as 'm_stub', which is never deleted.
+  node_type m_stub;
+
+  std::atomic<node_type*> lt_cacheline_aligned m_head{ &m_stub };
+  node_type* lt_cacheline_aligned m_tail{ &m_stub };
+};
+
+template<typename T>
+MpscQueue<T>::~MpscQueue() {
+  consume([](T&&) {});
+
+  if (m_tail != &m_stub)
+    delete m_tail;
+}
+
+template<typename T>
+inline void
+MpscQueue<T>::push(T value) {
+  node_type* node = new node_type{ std::move(value) };
+  node_type* prev = m_head.exchange(node, std::memory_order_acq_rel);
+
+  prev->next.store(node, std::memory_order_release);
+}
+
+template<typename T>
+template<typename Func>
+size_t
+MpscQueue<T>::consume(Func func) {
+  node_type* last  = m_head.load(std::memory_order_acquire);
+  size_t     count = 0;
+
+  while (m_tail != last) {
+    node_type* next = m_tail->next.load(std::memory_order_acquire);
+
+    if (next == nullptr)
+      break;
+
+    T value = std::move(next->value);
+
+    if (m_tail != &m_stub)
+      delete m_tail;
+
+    m_tail = next;
+    count++;
+
+    func(std::move(value));
+  }
+
+  return count;
+}
+
+}
+
+#endif
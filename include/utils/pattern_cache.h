@@ -0,0 +1,82 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+// Copyright (C) 2021, Contributors to the rTorrent project
+
+#ifndef RTORRENT_UTILS_PATTERN_CACHE_H
+#define RTORRENT_UTILS_PATTERN_CACHE_H
+
+#include <memory>
+#include <mutex>
+#include <regex>
+#include <string>
+#include <unordered_map>
+#include <utility>
+
+namespace utils {
+
+// A compiled regular expression used for whole-string matching.
+//
+// Patterns that are plain literals, optionally with a leading and/or
+// trailing '.*', are matched with string comparisons instead of
+// std::regex.
+class Pattern {
+public:
+  enum match_type {
+    match_literal,
+    match_prefix,
+    match_suffix,
+    match_contains,
+    match_regex,
+    match_invalid
+  };
+
+  Pattern(const std::string& pattern);
+
+  bool is_valid() const {
+    return m_type != match_invalid;
+  }
+
+  match_type         type() const {
+    return m_type;
+  }
+  const std::string& error() const {
+    return m_error;
+  }
+
+  // Equivalent to 'std::regex_match(str, std::regex(pattern))',
+  // always false for invalid patterns.
+  bool match(const std::string& str) const;
+
+private:
+  match_type  m_type;
+  std::string m_literal;
+  std::regex  m_regex;
+  std::string m_error;
+};
+
+// Shared cache of compiled patterns keyed by the pattern string. The
+// cache is cleared once it grows past 'max_size' entries.
+class PatternCache {
+public:
+  using pointer = std::shared_ptr<const Pattern>;
+
+  static constexpr size_t max_size = 256;
+
+  // Returns the compiled pattern, and true if it was compiled by this
+  // call. Invalid patterns are cached too, so callers can report the
+  // error once.
+  std::pair<pointer, bool> insert(const std::string& pattern);
+
+  size_t size() const;
+  void   clear();
+
+private:
+  mutable std::mutex                       m_mutex;
+  std::unordered_map<std::string, pointer> m_patterns;
+};
+
+PatternCache&
+pattern_cache();
+
+}
+
+#endif
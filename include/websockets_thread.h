@@ -2,6 +2,7 @@
 #define RTORRENT_WEBSOCKETS_THREAD_H
 
 #include "protocol_thread.h"
+#include "rpc/event_bus.h"
 #include "rpc/rpc_manager.h"
 #include "rpc/parse_commands.h"
 
@@ -13,6 +14,8 @@
 
 struct ConnectionData {
   std::string_view address;
+  // Normalized event bus topics the connection is subscribed to.
+  std::vector<std::string> topics;
   ConnectionData() = default;
 };
 
@@ -46,6 +49,10 @@ public:
 
   void publish_ws_topic(std::string_view topic, std::string_view message);
 
+  rpc::EventBus* event_bus() {
+    return &m_event_bus;
+  }
+
 private:
 
   std::unique_ptr<std::thread> m_websockets_thread = nullptr;
@@ -64,7 +71,11 @@ private:
 
   std::vector<uWS::WebSocket<false, true, ConnectionData>*> all_connection;
 
+  // Used by the loop thread until the destructor has joined it.
+  rpc::EventBus m_event_bus;
+
   void handle_request(const std::string_view&);
+  bool handle_subscription(uWS::WebSocket<false, true, ConnectionData>* ws, std::string_view request);
 };
 
 #endif
@@ -3,7 +3,6 @@
 
 #include <cstdio>
 #include <functional>
-#include <regex>
 
 #include <torrent/connection_manager.h>
 #include <torrent/data/download_data.h>
@@ -30,6 +29,7 @@
 #include "core/download_store.h"
 #include "core/manager.h"
 #include "rpc/parse.h"
+#include "utils/pattern_cache.h"
 
 #include "command_helpers.h"
 #include "control.h"
@@ -403,58 +403,62 @@ f_multicall(core::Download* download, const torrent::Object::list_type& args) {
   if (args.empty())
     throw torrent::input_error("Too few arguments.");
 
-  // We ignore the first arg for now, but it will be used for
-  // selecting what files to include.
+  // The first arg is a pattern or list of patterns for selecting what
+  // files to include, compiled patterns are shared between calls.
+  std::vector<utils::PatternCache::pointer> pattern_list;
 
-  // Add some pre-parsing of the commands, so we don't spend time
-  // parsing and searching command map for every single call.
-  torrent::Object             resultRaw = torrent::Object::create_list();
-  torrent::Object::list_type& result    = resultRaw.as_list();
-  std::vector<std::string>    regex_list;
+  auto add_pattern = [&pattern_list](const std::string& pattern) {
+    auto result = utils::pattern_cache().insert(pattern);
 
-  bool use_regex = true;
+    if (result.second && !result.first->is_valid())
+      control->core()->push_log_std("regex_error: " + result.first->error());
+
+    pattern_list.push_back(std::move(result.first));
+  };
 
   if (args.front().is_list())
-    std::transform(args.front().as_list().begin(),
-                   args.front().as_list().end(),
-                   std::back_inserter(regex_list),
-                   [](const auto& object) { return object.as_string_c(); });
+    std::for_each(
+      args.front().as_list().begin(),
+      args.front().as_list().end(),
+      [&add_pattern](const auto& object) { add_pattern(object.as_string_c()); });
   else if (args.front().is_string() && !args.front().as_string().empty())
-    regex_list.push_back(args.front().as_string());
-  else
-    use_regex = false;
+    add_pattern(args.front().as_string());
+
+  // Pre-parse the commands, so we don't spend time parsing and
+  // searching command map for every single call.
+  rpc::parsed_command_list commands;
+  commands.reserve(args.size() - 1);
+
+  for (torrent::Object::list_const_iterator cItr = ++args.begin();
+       cItr != args.end();
+       cItr++)
+    commands.push_back(rpc::parse_command_compile(cItr->as_string()));
+
+  torrent::Object             resultRaw = torrent::Object::create_list();
+  torrent::Object::list_type& result    = resultRaw.as_list();
 
   for (torrent::FileList::const_iterator itr  = download->file_list()->begin(),
                                          last = download->file_list()->end();
        itr != last;
        itr++) {
-    if (use_regex &&
-        std::find_if(
-          regex_list.begin(), regex_list.end(), [itr](std::string pattern) {
-            bool isAMatch = false;
-            try {
-              std::regex re(pattern);
-              isAMatch = std::regex_match((*itr)->path()->as_string(), re);
-            } catch (const std::regex_error& e) {
-              control->core()->push_log_std("regex_error: " +
-                                            std::string(e.what()));
-            }
-            return isAMatch;
-          }) == regex_list.end())
-      continue;
+    if (!pattern_list.empty()) {
+      const std::string& path = (*itr)->path()->as_string();
+
+      if (std::none_of(pattern_list.begin(),
+                       pattern_list.end(),
+                       [&path](const auto& pattern) {
+                         return pattern->match(path);
+                       }))
+        continue;
+    }
 
     torrent::Object::list_type& row =
       result.insert(result.end(), torrent::Object::create_list())->as_list();
 
-    for (torrent::Object::list_const_iterator cItr = ++args.begin();
-         cItr != args.end();
-         cItr++) {
-      const std::string& cmd = cItr->as_string();
-      row.push_back(rpc::parse_command(rpc::make_target(*itr),
-                                       cmd.c_str(),
-                                       cmd.c_str() + cmd.size())
-                      .first);
-    }
+    row.reserve(commands.size());
+
+    for (const auto& cmd : commands)
+      row.push_back(rpc::call_parsed_command(cmd, rpc::make_target(*itr)));
   }
 
   return resultRaw;
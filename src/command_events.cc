@@ -5,17 +5,20 @@
 #include <functional>
 #include <torrent/hash_string.h>
 #include <torrent/rate.h>
-#include <torrent/utils/directory_events.h>
+#include <torrent/torrent.h>
 #include <torrent/utils/error_number.h>
 #include <torrent/utils/file_stat.h>
 #include <torrent/utils/log.h>
 #include <torrent/utils/path.h>
 #include <torrent/utils/string_manip.h>
+#include <torrent/utils/thread_base.h>
 
 #include "core/download.h"
 #include "core/download_list.h"
+#include "core/http_queue.h"
 #include "core/manager.h"
 #include "core/view_manager.h"
+#include "core/watch_directories.h"
 #include "rpc/command_scheduler.h"
 #include "rpc/parse.h"
 #include "rpc/parse_commands.h"
@@ -199,6 +202,21 @@ apply_schedule(const torrent::Object::list_type& args) {
   return torrent::Object();
 }
 
+// Sets the HttpQueue priority of the downloads created in its scope.
+class http_priority_scope {
+public:
+  http_priority_scope(int priority)
+    : m_saved(control->core()->http_priority()) {
+    control->core()->set_http_priority(priority);
+  }
+  ~http_priority_scope() {
+    control->core()->set_http_priority(m_saved);
+  }
+
+private:
+  int m_saved;
+};
+
 torrent::Object
 apply_load(const torrent::Object::list_type& args, int flags) {
   torrent::Object::list_const_iterator argsItr = args.begin();
@@ -303,8 +321,16 @@ d_multicall(const torrent::Object::list_type& args) {
   if (viewItr == viewManager->end())
     throw torrent::input_error("Could not find view.");
 
-  // Add some pre-parsing of the commands, so we don't spend time
-  // parsing and searching command map for every single call.
+  // Pre-parse the commands, so we don't spend time parsing and
+  // searching command map for every single call.
+  rpc::parsed_command_list commands;
+  commands.reserve(args.size() - 1);
+
+  for (torrent::Object::list_const_iterator cItr = ++args.begin();
+       cItr != args.end();
+       cItr++)
+    commands.push_back(rpc::parse_command_compile(cItr->as_string()));
+
   unsigned int     dlist_size = (*viewItr)->size_visible();
   core::Download** dlist =
     static_cast<core::Download**>(malloc(sizeof(core::Download*) * dlist_size));
@@ -318,15 +344,10 @@ d_multicall(const torrent::Object::list_type& args) {
     torrent::Object::list_type& row =
       result.insert(result.end(), torrent::Object::create_list())->as_list();
 
-    for (torrent::Object::list_const_iterator cItr = ++args.begin();
-         cItr != args.end();
-         cItr++) {
-      const std::string& cmd = cItr->as_string();
-      row.push_back(rpc::parse_command(rpc::make_target(*vItr),
-                                       cmd.c_str(),
-                                       cmd.c_str() + cmd.size())
-                      .first);
-    }
+    row.reserve(commands.size());
+
+    for (const auto& cmd : commands)
+      row.push_back(rpc::call_parsed_command(cmd, rpc::make_target(*vItr)));
   }
 
   free(dlist);
@@ -354,26 +375,29 @@ d_multicall_filtered(const torrent::Object::list_type& args) {
   core::View::base_type dlist;
   (*viewItr)->filter_by(*++arg, dlist);
 
+  // Pre-parse the provided commands once for all items
+  rpc::parsed_command_list commands;
+  commands.reserve(args.size() - 2);
+
+  for (torrent::Object::list_const_iterator command = ++arg;
+       command != args.end();
+       command++)
+    commands.push_back(rpc::parse_command_compile(command->as_string()));
+
   // Generate result by iterating over all items
   torrent::Object             resultRaw = torrent::Object::create_list();
   torrent::Object::list_type& result    = resultRaw.as_list();
-  ++arg; // skip to first command
 
   for (core::View::iterator item = dlist.begin(); item != dlist.end(); ++item) {
     // Add empty row to result
     torrent::Object::list_type& row =
       result.insert(result.end(), torrent::Object::create_list())->as_list();
 
+    row.reserve(commands.size());
+
     // Call the provided commands and assemble their results
-    for (torrent::Object::list_const_iterator command = arg;
-         command != args.end();
-         command++) {
-      const std::string& cmdstr = command->as_string();
-      row.push_back(rpc::parse_command(rpc::make_target(*item),
-                                       cmdstr.c_str(),
-                                       cmdstr.c_str() + cmdstr.size())
-                      .first);
-    }
+    for (const auto& cmd : commands)
+      row.push_back(rpc::call_parsed_command(cmd, rpc::make_target(*item)));
   }
 
   return resultRaw;
@@ -381,27 +405,27 @@ d_multicall_filtered(const torrent::Object::list_type& args) {
 
 static void
 call_watch_command(const std::string& command, const std::string& path) {
+  http_priority_scope scope(core::HttpQueue::priority_watch);
   rpc::commands.call_catch(command.c_str(), rpc::make_target(), path);
 }
 
 torrent::Object
-directory_watch_added(const torrent::Object::list_type& args) {
+directory_watch_added(const torrent::Object::list_type& args, int flags) {
   if (args.size() != 2)
     throw torrent::input_error("Too few arguments.");
 
   const std::string& path    = args.front().as_string();
   const std::string& command = args.back().as_string();
 
-  if (!control->directory_events()->open())
+  if (!control->watch_directories()->open(torrent::main_thread()->poll()))
     throw torrent::input_error(
       "Could not open inotify:" +
       torrent::utils::error_number::current().message());
 
-  control->directory_events()->notify_on(
-    path.c_str(),
-    torrent::directory_events::flag_on_added |
-      torrent::directory_events::flag_on_updated,
-    [command](const auto& path) { return call_watch_command(command, path); });
+  control->watch_directories()->insert(
+    path, flags, [command](const auto& path) {
+      return call_watch_command(command, path);
+    });
   return torrent::Object();
 }
 
@@ -459,6 +483,17 @@ initialize_command_events() {
     return apply_load(args,
                       core::Manager::create_tied | core::Manager::create_start);
   }, false);
+  CMD2_ANY_LIST("load.feed", [](const auto&, const auto& args) {
+    http_priority_scope scope(core::HttpQueue::priority_feed);
+    return apply_load(args,
+                      core::Manager::create_quiet | core::Manager::create_tied);
+  }, false);
+  CMD2_ANY_LIST("load.start_feed", [](const auto&, const auto& args) {
+    http_priority_scope scope(core::HttpQueue::priority_feed);
+    return apply_load(args,
+                      core::Manager::create_quiet | core::Manager::create_tied |
+                        core::Manager::create_start);
+  }, false);
   CMD2_ANY_LIST("load.raw", [](const auto&, const auto& args) {
     return apply_load(
       args, core::Manager::create_quiet | core::Manager::create_raw_data);
@@ -492,6 +527,29 @@ initialize_command_events() {
   }, false);
 
   CMD2_ANY_LIST("directory.watch.added", [](const auto&, const auto& args) {
-    return directory_watch_added(args);
+    return directory_watch_added(args, 0);
   }, false);
+  CMD2_ANY_LIST("directory.watch.recursive",
+                [](const auto&, const auto& args) {
+                  return directory_watch_added(
+                    args, core::WatchDirectories::flag_recursive);
+                }, false);
+  CMD2_ANY("directory.watch.debounce", [](const auto&, const auto&) {
+    return control->watch_directories()->debounce();
+  }, true);
+  CMD2_ANY_VALUE_V("directory.watch.debounce.set",
+                   [](const auto&, const auto& seconds) {
+                     return control->watch_directories()->set_debounce(seconds);
+                   }, false);
+  CMD2_ANY("directory.watch.scan_existing", [](const auto&, const auto&) {
+    return control->watch_directories()->scan_existing();
+  }, true);
+  CMD2_ANY_VALUE_V("directory.watch.scan_existing.set",
+                   [](const auto&, const auto& v) {
+                     return control->watch_directories()->set_scan_existing(
+                       v != 0);
+                   }, false);
+  CMD2_ANY("directory.watch.pending", [](const auto&, const auto&) {
+    return control->watch_directories()->pending();
+  }, true);
 }
@@ -224,8 +224,11 @@ initialize_command_local() {
     return control->core()->file_status_cache()->size();
   }, true);
   CMD2_ANY_V("system.file_status_cache.prune", [](const auto&, const auto&) {
-    return control->core()->file_status_cache()->prune();
+    return control->core()->prune_file_status();
   }, false);
+  CMD2_ANY("system.file_status_cache.pruning", [](const auto&, const auto&) {
+    return control->core()->is_pruning_file_status();
+  }, true);
 
   CMD2_VAR_BOOL("file.prioritize_toc", 0, false);
   CMD2_VAR_LIST("file.prioritize_toc.first", false);
@@ -373,6 +376,30 @@ initialize_command_local() {
     "session.path.set",
     [dStore](const auto&, const auto& path) { return dStore->set_path(path); }, false);
 
+  CMD2_ANY("session.use_snapshot", [dStore](const auto&, const auto&) {
+    return dStore->use_snapshot();
+  }, true);
+  CMD2_ANY_VALUE_V("session.use_snapshot.set",
+                   [dStore](const auto&, const auto& v) {
+                     return dStore->set_use_snapshot(v);
+                   }, false);
+
+  CMD2_ANY("session.stats.written", [dStore](const auto&, const auto&) {
+    return dStore->saved_torrents();
+  }, true);
+  CMD2_ANY("session.stats.skipped", [dStore](const auto&, const auto&) {
+    return dStore->skipped_torrents();
+  }, true);
+  CMD2_ANY("session.stats.bytes_written", [dStore](const auto&, const auto&) {
+    return dStore->saved_bytes();
+  }, true);
+  CMD2_ANY("session.stats.failed", [dStore](const auto&, const auto&) {
+    return dStore->failed_torrents();
+  }, true);
+
+  CMD2_ANY("session.save.in_progress", [dStore](const auto&, const auto&) {
+    return dStore->is_saving();
+  }, true);
   CMD2_ANY_V("session.save", [dList](const auto&, const auto&) {
     return dList->session_save();
   }, false);
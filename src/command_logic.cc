@@ -1,5 +1,3 @@
-#include <regex>
-
 #include <torrent/utils/algorithm.h>
 #include <torrent/utils/log.h>
 
@@ -8,6 +6,7 @@
 #include "core/manager.h"
 #include "rpc/parse.h"
 #include "ui/root.h"
+#include "utils/pattern_cache.h"
 
 torrent::Object
 apply_cat(rpc::target_type, const torrent::Object& rawArgs) {
@@ -317,15 +316,12 @@ apply_match(rpc::target_type target, const torrent::Object::list_type& args) {
   std::transform(text.begin(), text.end(), text.begin(), ::tolower);
   std::transform(pattern.begin(), pattern.end(), pattern.begin(), ::tolower);
 
-  bool isAMatch = false;
-  try {
-    std::regex re(pattern);
-    isAMatch = std::regex_match(text, re);
-  } catch (const std::regex_error& exc) {
-    control->core()->push_log_std("regex_error: " + std::string(exc.what()));
-  }
+  auto compiled = utils::pattern_cache().insert(pattern);
+
+  if (compiled.second && !compiled.first->is_valid())
+    control->core()->push_log_std("regex_error: " + compiled.first->error());
 
-  return isAMatch ? (int64_t) true : (int64_t) false;
+  return compiled.first->match(text) ? (int64_t) true : (int64_t) false;
 }
 
 torrent::Object
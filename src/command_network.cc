@@ -22,6 +22,7 @@
 #include <torrent/utils/path.h>
 
 #include "core/download.h"
+#include "core/http_queue.h"
 #include "core/manager.h"
 #include "rpc/parse.h"
 #include "rpc/parse_commands.h"
@@ -230,6 +231,9 @@ apply_scgi(const std::string& arg, int type) {
     throw torrent::input_error(e.what());
   }
 
+  scgi->set_keep_alive(rpc::call_command_value("network.scgi.keep_alive"));
+  scgi->set_keep_alive_timeout(
+    rpc::call_command_value("network.scgi.keep_alive_timeout"));
   worker_thread->set_scgi_protocol(scgi);
 
   return torrent::Object();
@@ -255,6 +259,7 @@ initialize_command_network() {
   torrent::ConnectionManager* cm          = torrent::connection_manager();
   torrent::FileManager*       fileManager = torrent::file_manager();
   core::CurlStack*            httpStack   = control->core()->http_stack();
+  core::HttpQueue*            httpQueue   = control->core()->http_queue();
 
   CMD2_ANY_STRING("encoding.add", [](const auto&, const auto& arg) {
     return apply_encoding_list(arg);
@@ -324,6 +329,34 @@ initialize_command_network() {
                     [httpStack](const auto&, const auto& s) {
                       return httpStack->set_http_proxy(s);
                     }, false);
+  CMD2_ANY("network.http.queue.max_open",
+           [httpQueue](const auto&, const auto&) {
+             return httpQueue->max_active();
+           }, true);
+  CMD2_ANY_VALUE_V("network.http.queue.max_open.set",
+                   [httpQueue](const auto&, const auto& a) {
+                     return httpQueue->set_max_active(a);
+                   }, false);
+  CMD2_ANY("network.http.queue.max_per_host",
+           [httpQueue](const auto&, const auto&) {
+             return httpQueue->max_per_host();
+           }, true);
+  CMD2_ANY_VALUE_V("network.http.queue.max_per_host.set",
+                   [httpQueue](const auto&, const auto& a) {
+                     return httpQueue->set_max_per_host(a);
+                   }, false);
+  CMD2_ANY("network.http.queue.pending",
+           [httpQueue](const auto&, const auto&) {
+             return httpQueue->pending();
+           }, true);
+  CMD2_ANY("network.http.reuse_connections",
+           [httpStack](const auto&, const auto&) {
+             return httpStack->reuse_connections();
+           }, true);
+  CMD2_ANY_VALUE_V("network.http.reuse_connections.set",
+                   [httpStack](const auto&, const auto& v) {
+                     return httpStack->set_reuse_connections(v);
+                   }, false);
   CMD2_ANY("network.http.ssl_verify_host",
            [httpStack](const auto&, const auto&) {
              return httpStack->ssl_verify_host();
@@ -405,7 +438,36 @@ initialize_command_network() {
   CMD2_ANY_STRING("network.websockets_scgi.open_local", [](const auto&, const auto& arg) {
       return apply_websockets_scgi(arg, 2);
   }, false);
+  CMD2_ANY("network.websockets_scgi.flush_interval", [](const auto&, const auto&) {
+    return (int64_t)worker_thread->event_bus()->flush_interval();
+  }, true);
+  CMD2_ANY_VALUE_V("network.websockets_scgi.flush_interval.set",
+                   [](const auto&, const auto& ms) {
+                     return worker_thread->event_bus()->set_flush_interval(ms);
+                   }, false);
+  CMD2_ANY("network.websockets_scgi.pending_events", [](const auto&, const auto&) {
+    return (int64_t)worker_thread->event_bus()->pending();
+  }, true);
   CMD2_VAR_BOOL("network.scgi.dont_route", false, false);
+  CMD2_VAR_BOOL("network.scgi.keep_alive", false, false);
+  CMD2_VAR_VALUE("network.scgi.keep_alive_timeout", 60, false);
+  CMD2_ANY("network.scgi.rejected", [](const auto&, const auto&) {
+    auto scgi = static_cast<rpc::SCgi*>(worker_thread->scgi_protocol());
+    return scgi != nullptr ? (int64_t)scgi->rejected() : (int64_t)0;
+  }, true);
+
+  // Threads executing read-only JSON-RPC requests, zero runs all
+  // requests on the thread that received them.
+  CMD2_ANY("network.rpc.worker_threads", [](const auto&, const auto&) {
+    return (int64_t)rpc::rpc.worker_threads();
+  }, true);
+  CMD2_ANY_VALUE_V("network.rpc.worker_threads.set",
+                   [](const auto&, const auto& v) {
+                     if (v < 0)
+                       throw torrent::input_error("Invalid number of RPC worker threads.");
+
+                     return rpc::rpc.set_worker_threads(v);
+                   }, false);
 
   CMD2_ANY("network.xmlrpc.size_limit", [](const auto&, const auto&) {
     return std::numeric_limits<size_t>::max();
@@ -229,6 +229,14 @@ initialize_command_ui() {
   CMD2_ANY_LIST("view.sort", [](const auto&, const auto& args) {
     return apply_view_sort(args);
   }, false);
+  CMD2_ANY("view.refresh_interval", [](const auto&, const auto&) {
+    return (int64_t)control->view_manager()->refresh_interval();
+  }, true);
+  CMD2_ANY_VALUE_V("view.refresh_interval.set",
+                   [](const auto&, const auto& seconds) {
+                     return control->view_manager()->set_refresh_interval(
+                       seconds);
+                   }, false);
   CMD2_ANY_LIST("view.sort_new", [](const auto&, const auto& args) {
     return apply_view_event(&core::ViewManager::set_sort_new, args);
   }, false);
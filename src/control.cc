@@ -9,13 +9,13 @@
 #include <unistd.h>
 
 #include <torrent/connection_manager.h>
-#include <torrent/utils/directory_events.h>
 
 #include "core/dht_manager.h"
 #include "core/download_store.h"
 #include "core/http_queue.h"
 #include "core/manager.h"
 #include "core/view_manager.h"
+#include "core/watch_directories.h"
 
 #include "display/canvas.h"
 #include "display/manager.h"
@@ -39,7 +39,7 @@ Control::Control()
 
   m_commandScheduler(new rpc::CommandScheduler())
   , m_objectStorage(new rpc::object_storage())
-  , m_directory_events(new torrent::directory_events()) {
+  , m_watchDirectories(new core::WatchDirectories()) {
 
   m_core        = new core::Manager();
   m_viewManager = new core::ViewManager();
@@ -65,7 +65,7 @@ Control::~Control() {
   delete m_core;
   delete m_dhtManager;
 
-  delete m_directory_events;
+  delete m_watchDirectories;
   delete m_commandScheduler;
   delete m_objectStorage;
 }
@@ -106,6 +106,7 @@ Control::cleanup() {
   }
 
   m_core->download_store()->disable();
+  m_watchDirectories->close();
 
   m_ui->cleanup();
   m_core->cleanup();
@@ -169,7 +170,7 @@ Control::handle_shutdown() {
 
   if (!m_shutdownQuick) {
     torrent::connection_manager()->listen_close();
-    m_directory_events->close();
+    m_watchDirectories->close();
     m_core->shutdown(false);
   } else {
     m_core->shutdown(true);
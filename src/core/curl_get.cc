@@ -60,7 +60,7 @@ CurlGet::start() {
                             torrent::utils::timer::from_seconds(m_timeout + 5));
   }
 
-  curl_easy_setopt(m_handle, CURLOPT_FORBID_REUSE, (long)1);
+  m_stack->prepare_handle(m_handle);
   curl_easy_setopt(m_handle, CURLOPT_NOSIGNAL, (long)1);
   curl_easy_setopt(m_handle, CURLOPT_FOLLOWLOCATION, (long)1);
   curl_easy_setopt(m_handle, CURLOPT_MAXREDIRS, (long)5);
@@ -3,6 +3,7 @@
 
 #include <algorithm>
 
+#include <curl/curl.h>
 #include <curl/multi.h>
 #include <torrent/exceptions.h>
 
@@ -29,9 +30,44 @@ CurlStack::~CurlStack() {
     front()->close();
 
   curl_multi_cleanup((CURLM*)m_handle);
+
+  if (m_share != nullptr)
+    curl_share_cleanup((CURLSH*)m_share);
+
   priority_queue_erase(&taskScheduler, &m_taskTimeout);
 }
 
+// The share handle is only created once and kept until the stack is
+// destroyed, as transfers started before disabling reuse may still be
+// using it. All transfers run on the main thread, so no lock functions
+// are needed.
+void
+CurlStack::set_reuse_connections(bool s) {
+  m_reuseConnections = s;
+
+  if (!s || m_share != nullptr)
+    return;
+
+  CURLSH* share = curl_share_init();
+
+  if (share == nullptr)
+    throw torrent::internal_error("Call to curl_share_init() failed.");
+
+  curl_share_setopt(share, CURLSHOPT_SHARE, CURL_LOCK_DATA_DNS);
+  curl_share_setopt(share, CURLSHOPT_SHARE, CURL_LOCK_DATA_SSL_SESSION);
+  curl_share_setopt(share, CURLSHOPT_SHARE, CURL_LOCK_DATA_CONNECT);
+
+  m_share = share;
+}
+
+void
+CurlStack::prepare_handle(void* handle) {
+  if (m_reuseConnections)
+    curl_easy_setopt((CURL*)handle, CURLOPT_SHARE, (CURLSH*)m_share);
+  else
+    curl_easy_setopt((CURL*)handle, CURLOPT_FORBID_REUSE, (long)1);
+}
+
 CurlGet*
 CurlStack::new_object() {
   return new CurlGet(this);
@@ -28,6 +28,7 @@
 #include "core/download.h"
 #include "core/download_factory.h"
 #include "core/download_store.h"
+#include "core/session_loader.h"
 
 namespace core {
 
@@ -53,15 +54,9 @@ static bool
 download_factory_add_stream(torrent::Object* root,
                             const char*      key,
                             const char*      filename) {
-  std::fstream stream(filename, std::ios::in | std::ios::binary);
-
-  if (!stream.is_open())
-    return false;
-
   torrent::Object obj;
-  stream >> obj;
 
-  if (!stream.good())
+  if (!DownloadStore::read_bencode(filename, &obj))
     return false;
 
   root->insert_key_move(key, obj);
@@ -114,6 +109,24 @@ DownloadFactory::load_raw_data(const std::string& input) {
   m_loaded = true;
 }
 
+void
+DownloadFactory::load_session(SessionEntry&& entry) {
+  m_uri     = entry.path;
+  m_session = true;
+
+  if (!entry.error.empty())
+    return receive_failed(entry.error);
+
+  m_object    = entry.object.release();
+  m_isFile    = true;
+  m_preloaded = true;
+
+  m_sessionRtorrent.swap(entry.rtorrent);
+  m_sessionResume.swap(entry.resume);
+
+  receive_loaded();
+}
+
 void
 DownloadFactory::commit() {
   priority_queue_insert(&taskScheduler, &m_taskCommit, cachedTime);
@@ -131,8 +144,9 @@ DownloadFactory::receive_load() {
 
   if (is_network_uri(m_uri)) {
     // Http handling here.
-    m_stream                = new std::stringstream;
-    HttpQueue::iterator itr = m_manager->http_queue()->insert(m_uri, m_stream);
+    m_stream = new std::stringstream;
+    HttpQueue::iterator itr =
+      m_manager->http_queue()->insert(m_uri, m_stream, m_httpPriority);
 
     (*itr)->signal_done().push_front([this] { receive_loaded(); });
     (*itr)->signal_failed().push_front(
@@ -220,7 +234,13 @@ DownloadFactory::receive_success() {
       commands.push_back(*itr);
   }
 
-  if (m_session) {
+  if (m_preloaded) {
+    if (!m_sessionRtorrent.is_empty())
+      root->insert_key_move("rtorrent", m_sessionRtorrent);
+    if (!m_sessionResume.is_empty())
+      root->insert_key_move("libtorrent_resume", m_sessionResume);
+
+  } else if (m_session) {
     download_factory_add_stream(
       root,
       "rtorrent",
@@ -30,28 +30,47 @@
 #include "core/download_list.h"
 #include "core/download_store.h"
 #include "ui/root.h"
-#include "nlohmann/json.hpp"
 
 #define DL_TRIGGER_EVENT(download, event_name)                                 \
   rpc::commands.call_catch(event_name,                                         \
                            rpc::make_target(download),                         \
                            torrent::Object(),                                  \
                            "Event '" event_name "' failed: ");                 \
+  control->view_manager()->mark_dirty(download);                               \
   publish_topic(download, event_name);
 
 namespace core {
 
-void publish_topic(Download* download, std::string_view topic) {
-  nlohmann::json message = {
-    {"jsonrpc", "2.0"},
-    {"result", {
-                  {"target", torrent::utils::transform_hex_str(download->info()->hash().str())},
-                  {"event", topic},
-                  {"timestamp", std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::system_clock::now().time_since_epoch()).count()}
-                }
+// Queued for the websocket subscribers, which get the events in
+// batches. The event name must be a string literal.
+void publish_topic(Download* download, const char* event_name) {
+  rpc::EventBus* bus = worker_thread->event_bus();
+
+  if (!bus->is_open())
+    return;
+
+  uint64_t views = 0;
+
+  if (bus->has_view_subscribers()) {
+    ViewManager* view_manager = control->view_manager();
+
+    if (bus->view_count() != view_manager->size()) {
+      rpc::EventBus::view_list names;
+
+      for (const auto& view : *view_manager)
+        names.push_back(view->name());
+
+      bus->set_views(std::move(names));
     }
-  };
-  worker_thread->publish_ws_topic("event.*", message.dump());
+
+    for (size_t i = 0;
+         i < view_manager->size() && i < rpc::EventBus::max_views;
+         i++)
+      if ((*(view_manager->begin() + i))->is_visible(download))
+        views |= uint64_t(1) << i;
+  }
+
+  bus->push(download->info()->hash(), event_name, views);
 }
 
 #ifdef RT_USE_EXTRA_DEBUG
@@ -76,16 +95,17 @@ DownloadList::clear() {
   }
 
   base_type::clear();
+  m_hashIndex.clear();
 }
 
 void
 DownloadList::session_save() {
-  unsigned int c = std::count_if(begin(), end(), [](Download* download) {
-    return control->core()->download_store()->save_resume(download);
-  });
+  // Torrents are written by the session writer, which logs and counts
+  // those that fail.
+  for (const auto& download : *this)
+    control->core()->download_store()->save_resume(download);
 
-  if (c != size())
-    lt_log_print(torrent::LOG_ERROR, "Failed to save session torrents.");
+  control->core()->download_store()->sync_snapshot();
 
   control->dht_manager()->save_dht_cache();
   control->ui()->save_input_history();
@@ -93,9 +113,9 @@ DownloadList::session_save() {
 
 DownloadList::iterator
 DownloadList::find(const torrent::HashString& hash) {
-  return std::find_if(begin(), end(), [hash](Download* download) {
-    return hash == download->info()->hash();
-  });
+  hash_index::iterator itr = m_hashIndex.find(hash);
+
+  return itr != m_hashIndex.end() ? itr->second : end();
 }
 
 DownloadList::iterator
@@ -108,9 +128,7 @@ DownloadList::find_hex(const char* hash) {
     *itr = (torrent::utils::hexchar_to_value(*hash) << 4) +
            torrent::utils::hexchar_to_value(*(hash + 1));
 
-  return std::find_if(begin(), end(), [key](Download* download) {
-    return key == download->info()->hash();
-  });
+  return find(key);
 }
 
 Download*
@@ -173,9 +191,41 @@ DownloadList::create(std::istream* str) {
 }
 
 DownloadList::iterator
-DownloadList::insert(Download* download) {
+DownloadList::insert_indexed(Download*                  download,
+                             const torrent::HashString& hash) {
   iterator itr = base_type::insert(end(), download);
 
+  m_hashIndex[hash] = itr;
+  return itr;
+}
+
+// A download whose info-hash is indexed to another entry is searched
+// for in the list.
+DownloadList::iterator
+DownloadList::find_indexed(Download*                  download,
+                           const torrent::HashString& hash) {
+  iterator itr = find(hash);
+
+  if (itr == end() || *itr != download)
+    itr = std::find(begin(), end(), download);
+
+  return itr;
+}
+
+DownloadList::iterator
+DownloadList::erase_indexed(iterator itr, const torrent::HashString& hash) {
+  hash_index::iterator index_itr = m_hashIndex.find(hash);
+
+  if (index_itr != m_hashIndex.end() && index_itr->second == itr)
+    m_hashIndex.erase(index_itr);
+
+  return base_type::erase(itr);
+}
+
+DownloadList::iterator
+DownloadList::insert(Download* download) {
+  iterator itr = insert_indexed(download, download->info()->hash());
+
   lt_log_print_info(torrent::LOG_TORRENT_INFO,
                     download->info(),
                     "download_list",
@@ -222,7 +272,7 @@ DownloadList::insert(Download* download) {
 
 void
 DownloadList::erase_ptr(Download* download) {
-  erase(std::find(begin(), end(), download));
+  erase(find_indexed(download, download->info()->hash()));
 }
 
 DownloadList::iterator
@@ -248,10 +298,13 @@ DownloadList::erase(iterator itr) {
     v->erase(*itr);
   }
 
-  torrent::download_remove(*(*itr)->download());
-  delete *itr;
+  Download* download = *itr;
+  iterator  next     = erase_indexed(itr, download->info()->hash());
 
-  return base_type::erase(itr);
+  torrent::download_remove(*download->download());
+  delete download;
+
+  return next;
 }
 
 bool
@@ -3,9 +3,13 @@
 
 // DownloadStore handles the saving and listing of session torrents.
 
+#include <cerrno>
+#include <cinttypes>
 #include <cstdio>
+#include <fcntl.h>
 #include <fstream>
 #include <unistd.h>
+#include <zlib.h>
 
 #include <torrent/exceptions.h>
 #include <torrent/object.h>
@@ -13,6 +17,7 @@
 #include <torrent/rate.h>
 #include <torrent/torrent.h>
 #include <torrent/utils/error_number.h>
+#include <torrent/utils/log.h>
 #include <torrent/utils/path.h>
 #include <torrent/utils/resume.h>
 #include <torrent/utils/string_manip.h>
@@ -56,6 +61,11 @@ DownloadStore::enable(bool lock) {
       throw torrent::input_error(msg);
     }
   }
+
+  if (m_useSnapshot)
+    m_snapshot.open(m_path + "rtorrent.snapshot");
+
+  m_writer.start();
 }
 
 void
@@ -63,6 +73,8 @@ DownloadStore::disable() {
   if (!is_enabled())
     return;
 
+  m_writer.stop();
+  m_snapshot.close();
   m_lockfile.unlock();
 }
 
@@ -78,36 +90,221 @@ DownloadStore::set_path(const std::string& path) {
     m_path = torrent::utils::path_expand(path);
 }
 
+void
+DownloadStore::set_use_snapshot(bool v) {
+  if (is_enabled())
+    throw torrent::input_error(
+      "Tried to change session snapshot while the session is enabled.");
+
+  m_useSnapshot = v;
+}
+
+void
+DownloadStore::sync_snapshot() {
+  if (!m_snapshot.is_open())
+    return;
+
+  m_writer.push(std::string(), 0, [this]() {
+    if (m_snapshot.sync()) {
+      // Files left from before the snapshot was enabled would otherwise
+      // go stale, but are kept until the records replacing them are on
+      // disk.
+      for (const auto& base_filename : m_supersededFiles) {
+        ::unlink((base_filename + ".libtorrent_resume").c_str());
+        ::unlink((base_filename + ".rtorrent").c_str());
+      }
+
+      m_supersededFiles.clear();
+
+    } else {
+      lt_log_print(torrent::LOG_ERROR, "Failed to sync session snapshot.");
+    }
+
+    if (m_snapshot.needs_compaction() && !m_snapshot.compact())
+      lt_log_print(torrent::LOG_ERROR, "Failed to compact session snapshot.");
+
+    return true;
+  });
+}
+
+struct download_store_writer {
+  int      fd;
+  uLong    checksum;
+  uint64_t size;
+  bool     failed;
+};
+
+// The CRC-32 of a section file is stored as its '~crc32' key, which
+// sorts after any other key so the file stays a plain bencoded
+// dictionary. It covers the encoding of the dictionary without the key.
+static const char download_store_checksum_key[] = "~crc32";
+
+static torrent::object_buffer_t
+download_store_write(void* data, torrent::object_buffer_t buffer) {
+  auto*       writer = static_cast<download_store_writer*>(data);
+  const char* first  = buffer.first;
+
+  writer->checksum = ::crc32(writer->checksum,
+                             reinterpret_cast<const Bytef*>(first),
+                             buffer.second - first);
+  writer->size += buffer.second - first;
+
+  // Only computing the checksum.
+  if (writer->fd == -1)
+    return buffer;
+
+  while (!writer->failed && first != buffer.second) {
+    ssize_t result = ::write(writer->fd, first, buffer.second - first);
+
+    if (result == -1 && errno == EINTR)
+      continue;
+
+    if (result <= 0)
+      writer->failed = true;
+    else
+      first += result;
+  }
+
+  return buffer;
+}
+
+static void
+download_store_checksum(download_store_writer* writer,
+                        const torrent::Object& obj) {
+  char buffer[16384];
+
+  torrent::object_write_bencode_c(
+    &download_store_write,
+    writer,
+    torrent::object_buffer_t(buffer, buffer + sizeof(buffer)),
+    &obj,
+    0);
+}
+
+// Writes the bencoded 'obj' to 'filename' with '.new' appended, synced
+// to disk. The checksum is computed as the data is written instead of
+// reading the file back to check it, and stored in the file if
+// 'store_checksum' is set and 'obj' is a map.
+static bool
+download_store_write_temporary(const std::string&     filename,
+                               const torrent::Object& obj,
+                               uint32_t               skip_mask,
+                               uint64_t*              size,
+                               bool                   store_checksum = true) {
+  std::string tmp_filename = filename + ".new";
+  int         fd           = ::open(
+    tmp_filename.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0666);
+
+  if (fd == -1)
+    return false;
+
+  char                  buffer[16384];
+  download_store_writer writer{ fd, ::crc32(0L, Z_NULL, 0), 0, false };
+
+  try {
+    torrent::object_write_bencode_c(&download_store_write,
+                                    &writer,
+                                    torrent::object_buffer_t(
+                                      buffer, buffer + sizeof(buffer)),
+                                    &obj,
+                                    skip_mask);
+  } catch (const torrent::bencode_error&) {
+    writer.failed = true;
+  }
+
+  // Replaces the dictionary's closing 'e' with the key and a new 'e'.
+  if (store_checksum && obj.is_map() && !writer.failed && writer.size != 0) {
+    char key[64];
+    int  length = snprintf(key,
+                          sizeof(key),
+                          "%zu:%si%lue"
+                          "e",
+                          sizeof(download_store_checksum_key) - 1,
+                          download_store_checksum_key,
+                          (unsigned long)writer.checksum);
+
+    if (::pwrite(fd, key, length, writer.size - 1) != length)
+      writer.failed = true;
+
+    writer.size += length - 1;
+  }
+
+  bool failed = writer.failed || writer.size == 0 || ::fdatasync(fd) == -1;
+
+  if (::close(fd) == -1)
+    failed = true;
+
+  if (failed) {
+    ::unlink(tmp_filename.c_str());
+    return false;
+  }
+
+  lt_log_print(torrent::LOG_TORRENT_DEBUG,
+               "session: wrote '%s' (%" PRIu64 " bytes, crc32 %08lx)",
+               filename.c_str(),
+               writer.size,
+               writer.checksum);
+
+  if (size != nullptr)
+    *size = writer.size;
+
+  return true;
+}
+
+static bool
+download_store_rename(const std::string& filename) {
+  std::string tmp_filename = filename + ".new";
+
+  if (::rename(tmp_filename.c_str(), filename.c_str()) == -1) {
+    ::unlink(tmp_filename.c_str());
+    return false;
+  }
+
+  return true;
+}
+
 bool
 DownloadStore::write_bencode(const std::string&     filename,
                              const torrent::Object& obj,
-                             uint32_t               skip_mask) {
-  torrent::Object tmp;
-  std::fstream    output(filename.c_str(), std::ios::out | std::ios::trunc);
+                             uint32_t               skip_mask,
+                             uint64_t*              size) {
+  return download_store_write_temporary(filename, obj, skip_mask, size) &&
+         download_store_rename(filename);
+}
 
-  if (!output.is_open())
-    goto download_store_save_error;
+bool
+DownloadStore::read_bencode(const std::string& filename, torrent::Object* obj) {
+  std::fstream stream(filename.c_str(), std::ios::in | std::ios::binary);
 
-  torrent::object_write_bencode(&output, &obj, skip_mask);
+  if (!stream.is_open())
+    return false;
 
-  if (!output.good())
-    goto download_store_save_error;
+  stream >> *obj;
 
-  output.close();
+  if (!stream.good()) {
+    torrent::Object().swap(*obj);
+    return false;
+  }
 
-  // Test the new file, to ensure it is a valid bencode string.
-  output.open(filename.c_str(), std::ios::in);
-  output >> tmp;
+  // Files written without a checksum are only decoded.
+  if (!obj->is_map() || !obj->has_key_value(download_store_checksum_key))
+    return true;
 
-  if (!output.good())
-    goto download_store_save_error;
+  int64_t stored = obj->get_key_value(download_store_checksum_key);
+  obj->erase_key(download_store_checksum_key);
 
-  output.close();
-  return true;
+  download_store_writer writer{ -1, ::crc32(0L, Z_NULL, 0), 0, false };
+  download_store_checksum(&writer, *obj);
+
+  if (stored != (int64_t)writer.checksum) {
+    lt_log_print(torrent::LOG_WARN,
+                 "session: checksum mismatch in '%s'",
+                 filename.c_str());
+    torrent::Object().swap(*obj);
+    return false;
+  }
 
-download_store_save_error:
-  output.close();
-  return false;
+  return true;
 }
 
 bool
@@ -141,35 +338,154 @@ DownloadStore::save(Download* d, int flags) {
   resume_base->set_flags(torrent::Object::flag_session_data);
   rtorrent_base->set_flags(torrent::Object::flag_session_data);
 
-  std::string base_filename = create_filename(d);
+  // Stopped and idle torrents serialize to the same sections as last
+  // time, so only their checksum needs to be computed.
+  download_store_writer state{ -1, ::crc32(0L, Z_NULL, 0), 0, false };
+  download_store_checksum(&state, *rtorrent_base);
+  download_store_checksum(&state, *resume_base);
 
-  if (!write_bencode(
-        base_filename + ".libtorrent_resume.new", *resume_base, 0) ||
-      !write_bencode(base_filename + ".rtorrent.new", *rtorrent_base, 0))
-    return false;
+  bool unchanged = state.size == d->session_size() &&
+                   state.checksum == d->session_checksum();
+
+  std::string id = create_id(d);
+
+  // Retry sections whose last write failed on the writer thread.
+  if (m_writer.take_failed(id))
+    unchanged = false;
+
+  bool save_static = !(flags & flag_skip_static);
+
+  if (unchanged && !save_static) {
+    m_skippedTorrents++;
+    return true;
+  }
+
+  if (!unchanged)
+    d->set_session_saved(state.checksum, state.size);
+
+  // The writer thread gets copies of the sections, and of the torrent
+  // for a full save, as the download may change or be erased while the
+  // job is queued.
+  std::string     base_filename = create_filename(d);
+  torrent::Object rtorrent;
+  torrent::Object resume;
+  torrent::Object full;
 
-  ::rename((base_filename + ".libtorrent_resume.new").c_str(),
-           (base_filename + ".libtorrent_resume").c_str());
-  ::rename((base_filename + ".rtorrent.new").c_str(),
-           (base_filename + ".rtorrent").c_str());
+  if (!unchanged) {
+    rtorrent = *rtorrent_base;
+    resume   = *resume_base;
+  }
+
+  if (save_static)
+    full = *d->bencode();
+
+  size_t bytes = (unchanged ? 0 : state.size) +
+                 (save_static ? d->file_list()->size_chunks() * 20 : 0);
+
+  m_writer.push(id,
+                bytes,
+                [this,
+                 id,
+                 base_filename,
+                 rtorrent = std::move(rtorrent),
+                 resume   = std::move(resume),
+                 full     = std::move(full)]() {
+                  if (!write_sections(id, base_filename, rtorrent, resume) ||
+                      !write_static(base_filename, full))
+                    return false;
 
-  if (!(flags & flag_skip_static) &&
-      write_bencode(base_filename + ".new",
-                    *d->bencode(),
-                    torrent::Object::flag_session_data))
-    ::rename((base_filename + ".new").c_str(), base_filename.c_str());
+                  m_savedTorrents++;
+                  return true;
+                });
 
   return true;
 }
 
+// Called on the writer thread, empty objects are left as they are.
+bool
+DownloadStore::write_sections(const std::string&     id,
+                              const std::string&     base_filename,
+                              const torrent::Object& rtorrent,
+                              const torrent::Object& resume) {
+  if (rtorrent.is_empty())
+    return true;
+
+  uint64_t resume_size   = 0;
+  uint64_t rtorrent_size = 0;
+
+  if (m_snapshot.is_open()) {
+    bool     is_new    = !m_snapshot.has(id);
+    uint64_t last_size = m_snapshot.file_size();
+
+    if (!m_snapshot.write(id, rtorrent, resume))
+      return false;
+
+    if (is_new)
+      m_supersededFiles.push_back(base_filename);
+
+    m_savedBytes += m_snapshot.file_size() - last_size;
+
+  } else {
+    std::string resume_filename   = base_filename + ".libtorrent_resume";
+    std::string rtorrent_filename = base_filename + ".rtorrent";
+
+    // Both files are written before either is replaced, so a failed
+    // write leaves the previous pair in place.
+    if (!download_store_write_temporary(
+          resume_filename, resume, 0, &resume_size))
+      return false;
+
+    if (!download_store_write_temporary(
+          rtorrent_filename, rtorrent, 0, &rtorrent_size)) {
+      ::unlink((resume_filename + ".new").c_str());
+      return false;
+    }
+
+    if (!download_store_rename(resume_filename) ||
+        !download_store_rename(rtorrent_filename))
+      return false;
+
+    m_savedBytes += resume_size + rtorrent_size;
+  }
+
+  return true;
+}
+
+bool
+DownloadStore::write_static(const std::string&     filename,
+                            const torrent::Object& object) {
+  if (object.is_empty())
+    return true;
+
+  uint64_t size = 0;
+
+  // The torrent file is left as it was, without a checksum key.
+  if (!download_store_write_temporary(
+        filename, object, torrent::Object::flag_session_data, &size, false) ||
+      !download_store_rename(filename))
+    return false;
+
+  m_savedBytes += size;
+  return true;
+}
+
 void
 DownloadStore::remove(Download* d) {
   if (!is_enabled())
     return;
 
-  ::unlink((create_filename(d) + ".libtorrent_resume").c_str());
-  ::unlink((create_filename(d) + ".rtorrent").c_str());
-  ::unlink(create_filename(d).c_str());
+  // Queued so it can't be undone by a pending save of the download.
+  std::string id = create_id(d);
+
+  m_writer.push(id, 0, [this, id, filename = create_filename(d)]() {
+    if (m_snapshot.is_open())
+      m_snapshot.erase(id);
+
+    ::unlink((filename + ".libtorrent_resume").c_str());
+    ::unlink((filename + ".rtorrent").c_str());
+    ::unlink(filename.c_str());
+    return true;
+  });
 }
 
 // This also needs to check that it isn't a directory.
@@ -212,12 +528,15 @@ DownloadStore::is_correct_format(const std::string& f) {
   return true;
 }
 
+std::string
+DownloadStore::create_id(Download* d) {
+  return torrent::utils::transform_hex(d->info()->hash().begin(),
+                                       d->info()->hash().end());
+}
+
 std::string
 DownloadStore::create_filename(Download* d) {
-  return m_path +
-         torrent::utils::transform_hex(d->info()->hash().begin(),
-                                       d->info()->hash().end()) +
-         ".torrent";
+  return m_path + create_id(d) + ".torrent";
 }
 
 }
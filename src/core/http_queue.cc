@@ -1,9 +1,12 @@
 // SPDX-License-Identifier: GPL-2.0-or-later
 // Copyright (C) 2005-2011, Jari Sundell <jaris@ifi.uio.no>
 
+#include <algorithm>
+#include <cctype>
 #include <memory>
 #include <sstream>
 
+#include <torrent/exceptions.h>
 #include <torrent/http.h>
 
 #include "core/curl_get.h"
@@ -12,7 +15,10 @@
 namespace core {
 
 HttpQueue::iterator
-HttpQueue::insert(const std::string& url, std::iostream* s) {
+HttpQueue::insert(const std::string& url, std::iostream* s, int priority) {
+  if (priority < 0 || priority >= priority_size)
+    throw torrent::internal_error("HttpQueue::insert() invalid priority.");
+
   std::unique_ptr<CurlGet> h(m_slot_factory());
 
   h->set_url(url);
@@ -25,10 +31,11 @@ HttpQueue::insert(const std::string& url, std::iostream* s) {
   h->signal_failed().push_back(
     [this, signal_itr](const auto&) { erase(signal_itr); });
 
-  (*signal_itr)->start();
-
   h.release();
 
+  m_pending[priority].push_back(pending_type{ signal_itr, url_host(url) });
+  start_pending();
+
   for (signal_curl_get::iterator itr  = m_signal_insert.begin(),
                                  last = m_signal_insert.end();
        itr != last;
@@ -40,6 +47,23 @@ HttpQueue::insert(const std::string& url, std::iostream* s) {
 
 void
 HttpQueue::erase(iterator signal_itr) {
+  auto active_itr = m_activeHosts.find(*signal_itr);
+
+  if (active_itr != m_activeHosts.end()) {
+    auto host_itr = m_hostActive.find(active_itr->second);
+
+    if (--host_itr->second == 0)
+      m_hostActive.erase(host_itr);
+
+    m_activeHosts.erase(active_itr);
+
+  } else {
+    for (auto& list : m_pending)
+      list.remove_if([signal_itr](const pending_type& p) {
+        return p.itr == signal_itr;
+      });
+  }
+
   for (signal_curl_get::iterator itr  = m_signal_erase.begin(),
                                  last = m_signal_erase.end();
        itr != last;
@@ -48,14 +72,95 @@ HttpQueue::erase(iterator signal_itr) {
 
   delete *signal_itr;
   base_type::erase(signal_itr);
+
+  start_pending();
 }
 
 void
 HttpQueue::clear() {
+  // Don't start the waiting transfers only to close them right away.
+  for (auto& list : m_pending)
+    list.clear();
+
   while (!empty())
     erase(begin());
 
   base_type::clear();
 }
 
+unsigned int
+HttpQueue::pending() const {
+  unsigned int result = 0;
+
+  for (const auto& list : m_pending)
+    result += list.size();
+
+  return result;
+}
+
+void
+HttpQueue::set_max_active(unsigned int a) {
+  m_maxActive = a;
+  start_pending();
+}
+
+void
+HttpQueue::set_max_per_host(unsigned int a) {
+  m_maxPerHost = a;
+  start_pending();
+}
+
+std::string
+HttpQueue::url_host(const std::string& url) {
+  size_t first = url.find("://");
+  first        = first == std::string::npos ? 0 : first + 3;
+
+  std::string host = url.substr(first, url.find_first_of("/?#", first) - first);
+  size_t      at   = host.rfind('@');
+
+  if (at != std::string::npos)
+    host.erase(0, at + 1);
+
+  if (!host.empty() && host.front() == '[')
+    host.erase(std::min(host.find(']'), host.size() - 1) + 1);
+  else
+    host.erase(std::min(host.find(':'), host.size()));
+
+  std::transform(host.begin(), host.end(), host.begin(), [](unsigned char c) {
+    return std::tolower(c);
+  });
+
+  return host;
+}
+
+// Starts the waiting transfers the limits allow, going through the
+// priority classes in order. A transfer held back only by its host
+// limit doesn't block those behind it.
+void
+HttpQueue::start_pending() {
+  for (auto& list : m_pending) {
+    auto itr = list.begin();
+
+    while (itr != list.end()) {
+      if (m_maxActive != 0 && m_activeHosts.size() >= m_maxActive)
+        return;
+
+      unsigned int& host_active = m_hostActive[itr->host];
+
+      if (m_maxPerHost != 0 && host_active >= m_maxPerHost) {
+        ++itr;
+        continue;
+      }
+
+      CurlGet* http = *itr->itr;
+
+      host_active++;
+      m_activeHosts.emplace(http, std::move(itr->host));
+      itr = list.erase(itr);
+
+      http->start();
+    }
+  }
+}
+
 }
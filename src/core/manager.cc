@@ -113,6 +113,8 @@ Manager::Manager()
   torrent::Throttle* unthrottled = torrent::Throttle::create_throttle();
   unthrottled->set_max_rate(0);
   m_throttles["NULL"] = std::make_pair(unthrottled, unthrottled);
+
+  m_taskPruneFileStatus.slot() = [this] { receive_prune_file_status(); };
 }
 
 Manager::~Manager() {
@@ -217,6 +219,8 @@ Manager::cleanup() {
 
   m_downloadList->clear();
 
+  priority_queue_erase(&taskScheduler, &m_taskPruneFileStatus);
+
   // When we implement asynchronous DNS lookups, we need to cancel them
   // here before the torrent::* objects are deleted.
 
@@ -402,6 +406,20 @@ Manager::set_proxy_address(const std::string& addr) {
   }
 }
 
+void
+Manager::prune_file_status() {
+  if (!m_taskPruneFileStatus.is_queued())
+    priority_queue_insert(&taskScheduler, &m_taskPruneFileStatus, cachedTime);
+}
+
+void
+Manager::receive_prune_file_status() {
+  if (!m_fileStatusCache->prune_step(file_status_prune_batch))
+    priority_queue_insert(&taskScheduler,
+                          &m_taskPruneFileStatus,
+                          cachedTime + torrent::utils::timer::from_seconds(1));
+}
+
 void
 Manager::receive_http_failed(std::string msg) {
   push_log_std("Http download error: \"" + msg + "\"");
@@ -427,6 +445,7 @@ Manager::try_create_download(const std::string&       uri,
 
   f->set_start(flags & create_start);
   f->set_print_log(!(flags & create_quiet));
+  f->set_http_priority(m_httpPriority);
 
   if (flags & create_throw) {
     f->set_immediate(true);
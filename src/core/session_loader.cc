@@ -0,0 +1,149 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+// Copyright (C) 2021, Contributors to the rTorrent project
+
+#include <algorithm>
+#include <chrono>
+#include <fstream>
+
+#include <torrent/object_stream.h>
+#include <torrent/utils/path.h>
+
+#include "core/download_store.h"
+#include "core/session_loader.h"
+#include "core/session_snapshot.h"
+
+namespace core {
+
+// Mirrors what DownloadFactory::receive_load() and receive_success()
+// read for a session torrent.
+void
+SessionLoader::read_entry(SessionEntry*          entry,
+                          const SessionSnapshot* snapshot) {
+  std::string path = torrent::utils::path_expand(entry->path);
+  std::fstream stream(path.c_str(), std::ios::in | std::ios::binary);
+
+  if (!stream.is_open()) {
+    entry->error = "Could not open file";
+    return;
+  }
+
+  entry->object = std::make_unique<torrent::Object>();
+  stream >> *entry->object;
+
+  if (!stream.good()) {
+    entry->object.reset();
+    entry->error = "Reading torrent file failed";
+    return;
+  }
+
+  // Session files are named by the hex info-hash, which is also the
+  // snapshot id.
+  if (snapshot != nullptr) {
+    auto name = path.substr(path.rfind('/') + 1, SessionSnapshot::id_size);
+
+    if (snapshot->find(name, &entry->rtorrent, &entry->resume))
+      return;
+  }
+
+  DownloadStore::read_bencode(path + ".rtorrent", &entry->rtorrent);
+  DownloadStore::read_bencode(path + ".libtorrent_resume", &entry->resume);
+}
+
+SessionLoader::SessionLoader(path_list              paths,
+                             unsigned int           threads,
+                             const SessionSnapshot* snapshot)
+  : m_entries(paths.size()),
+    m_ready(paths.size(), 0),
+    m_snapshot(snapshot) {
+
+  for (size_t i = 0; i < paths.size(); i++)
+    m_entries[i].path = std::move(paths[i]);
+
+  if (threads == 0)
+    threads = std::thread::hardware_concurrency();
+
+  threads = std::clamp(threads, 1u, max_threads);
+  threads = std::min<size_t>(threads, std::max<size_t>(m_entries.size(), 1));
+
+  for (unsigned int i = 0; i < threads; i++)
+    m_threads.emplace_back([this] { run(); });
+}
+
+SessionLoader::~SessionLoader() {
+  stop();
+}
+
+void
+SessionLoader::stop() {
+  {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_stop = true;
+  }
+
+  m_condition.notify_all();
+
+  for (auto& thread : m_threads)
+    if (thread.joinable())
+      thread.join();
+}
+
+bool
+SessionLoader::next(SessionEntry* entry) {
+  std::unique_lock<std::mutex> lock(m_mutex);
+
+  if (m_stop || m_nextCommit == m_entries.size())
+    return false;
+
+  if (!m_ready[m_nextCommit]) {
+    auto start = std::chrono::steady_clock::now();
+
+    m_condition.wait(lock, [this] { return m_ready[m_nextCommit] != 0; });
+
+    m_waitSeconds += std::chrono::duration<double>(
+                       std::chrono::steady_clock::now() - start)
+                       .count();
+  }
+
+  *entry = std::move(m_entries[m_nextCommit++]);
+
+  lock.unlock();
+  m_condition.notify_all();
+  return true;
+}
+
+double
+SessionLoader::read_seconds() const {
+  std::lock_guard<std::mutex> lock(m_mutex);
+  return m_readSeconds;
+}
+
+void
+SessionLoader::run() {
+  std::unique_lock<std::mutex> lock(m_mutex);
+
+  while (true) {
+    m_condition.wait(lock, [this] {
+      return m_stop || m_nextRead == m_entries.size() ||
+             m_nextRead < m_nextCommit + max_pending;
+    });
+
+    if (m_stop || m_nextRead == m_entries.size())
+      return;
+
+    size_t index = m_nextRead++;
+    lock.unlock();
+
+    auto start = std::chrono::steady_clock::now();
+    read_entry(&m_entries[index], m_snapshot);
+    auto duration = std::chrono::duration<double>(
+                      std::chrono::steady_clock::now() - start)
+                      .count();
+
+    lock.lock();
+    m_readSeconds += duration;
+    m_ready[index] = 1;
+    m_condition.notify_all();
+  }
+}
+
+}
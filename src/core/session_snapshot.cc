@@ -0,0 +1,400 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+// Copyright (C) 2021, Contributors to the rTorrent project
+
+#include <cstdio>
+#include <cstring>
+#include <fcntl.h>
+#include <mutex>
+#include <sstream>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <zlib.h>
+
+#include <torrent/exceptions.h>
+#include <torrent/object_stream.h>
+
+#include "core/session_snapshot.h"
+
+namespace core {
+
+static bool
+session_snapshot_sync_directory(const std::string& path) {
+  std::string::size_type slash = path.rfind('/');
+  std::string directory = slash == std::string::npos ? std::string(".")
+                          : slash == 0               ? std::string("/")
+                                                     : path.substr(0, slash);
+
+  int fd = ::open(directory.c_str(), O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+
+  if (fd == -1)
+    return false;
+
+  bool result = ::fsync(fd) == 0;
+
+  if (::close(fd) == -1)
+    result = false;
+
+  return result;
+}
+
+static bool
+session_snapshot_write_all(int         fd,
+                           const char* data,
+                           size_t      length,
+                           off_t       offset) {
+  while (length != 0) {
+    ssize_t result = ::pwrite(fd, data, length, offset);
+
+    if (result <= 0)
+      return false;
+
+    data += result;
+    offset += result;
+    length -= result;
+  }
+
+  return true;
+}
+
+SessionSnapshot::~SessionSnapshot() {
+  close();
+}
+
+void
+SessionSnapshot::open(const std::string& path) {
+  std::unique_lock<std::shared_mutex> lock(m_mutex);
+
+  if (m_fd != -1)
+    throw torrent::internal_error("SessionSnapshot::open() already open.");
+
+  m_fd = ::open(path.c_str(), O_RDWR | O_CREAT | O_CLOEXEC, 0644);
+
+  if (m_fd == -1)
+    throw torrent::input_error("Could not open session snapshot \"" + path +
+                               "\": " + std::strerror(errno));
+
+  m_path = path;
+  map_file();
+
+  if (!replay()) {
+    unmap_file();
+
+    if (::ftruncate(m_fd, m_fileSize) == -1)
+      throw torrent::input_error("Could not truncate session snapshot \"" +
+                                 path + "\": " + std::strerror(errno));
+
+    map_file();
+  }
+}
+
+void
+SessionSnapshot::close() {
+  std::unique_lock<std::shared_mutex> lock(m_mutex);
+
+  if (m_fd == -1)
+    return;
+
+  unmap_file();
+  ::close(m_fd);
+
+  m_fd = -1;
+  m_index.clear();
+  m_fileSize = 0;
+  m_liveSize = 0;
+}
+
+void
+SessionSnapshot::map_file() {
+  struct stat st;
+
+  if (::fstat(m_fd, &st) == -1 || st.st_size == 0)
+    return;
+
+  void* map = ::mmap(nullptr, st.st_size, PROT_READ, MAP_SHARED, m_fd, 0);
+
+  if (map == MAP_FAILED)
+    return;
+
+  m_map     = static_cast<const char*>(map);
+  m_mapSize = st.st_size;
+}
+
+void
+SessionSnapshot::unmap_file() {
+  if (m_map != nullptr)
+    ::munmap(const_cast<char*>(m_map), m_mapSize);
+
+  m_map     = nullptr;
+  m_mapSize = 0;
+}
+
+// Returns false if the file had a damaged tail, with 'm_fileSize' set
+// to the end of the last good record.
+bool
+SessionSnapshot::replay() {
+  m_index.clear();
+  m_fileSize = 0;
+  m_liveSize = 0;
+
+  while (m_fileSize + sizeof(record_header) <= m_mapSize) {
+    record_header header;
+    std::memcpy(&header, m_map + m_fileSize, sizeof(record_header));
+
+    uint64_t payload = m_fileSize + sizeof(record_header);
+
+    if (header.magic != record_magic || header.length > m_mapSize - payload ||
+        header.checksum != checksum(header, m_map + payload))
+      break;
+
+    std::string id(header.id, id_size);
+    auto        itr = m_index.find(id);
+
+    if (itr != m_index.end()) {
+      m_liveSize -= sizeof(record_header) + itr->second.length;
+      m_index.erase(itr);
+    }
+
+    if (header.length != 0) {
+      m_index.emplace(std::move(id), entry_type{ m_fileSize, header.length });
+      m_liveSize += sizeof(record_header) + header.length;
+    }
+
+    m_fileSize = payload + header.length;
+  }
+
+  return m_fileSize == m_mapSize;
+}
+
+uint32_t
+SessionSnapshot::checksum(const record_header& header,
+                          const char*          payload) const {
+  uLong crc = ::crc32(0L, Z_NULL, 0);
+
+  crc = ::crc32(crc, reinterpret_cast<const Bytef*>(header.id), id_size);
+  crc = ::crc32(crc,
+                reinterpret_cast<const Bytef*>(&header.length),
+                sizeof(header.length));
+  crc = ::crc32(crc, reinterpret_cast<const Bytef*>(payload), header.length);
+
+  return crc;
+}
+
+bool
+SessionSnapshot::read_payload(const entry_type& entry,
+                              std::string*      payload) const {
+  uint64_t offset = entry.offset + sizeof(record_header);
+
+  if (offset + entry.length <= m_mapSize) {
+    payload->assign(m_map + offset, entry.length);
+    return true;
+  }
+
+  payload->resize(entry.length);
+
+  return ::pread(m_fd, &(*payload)[0], entry.length, offset) ==
+         (ssize_t)entry.length;
+}
+
+bool
+SessionSnapshot::has(const std::string& id) const {
+  std::shared_lock<std::shared_mutex> lock(m_mutex);
+  return m_index.find(id) != m_index.end();
+}
+
+bool
+SessionSnapshot::find(const std::string& id,
+                      torrent::Object*   rtorrent,
+                      torrent::Object*   resume) const {
+  std::string payload;
+
+  {
+    std::shared_lock<std::shared_mutex> lock(m_mutex);
+
+    auto itr = m_index.find(id);
+
+    if (itr == m_index.end() || !read_payload(itr->second, &payload))
+      return false;
+  }
+
+  try {
+    const char* first = payload.data();
+    const char* last  = payload.data() + payload.size();
+
+    first = torrent::object_read_bencode_c(first, last, rtorrent);
+    first = torrent::object_read_bencode_c(first, last, resume);
+
+    if (first == last)
+      return true;
+
+  } catch (const torrent::bencode_error&) {
+  }
+
+  torrent::Object().swap(*rtorrent);
+  torrent::Object().swap(*resume);
+  return false;
+}
+
+bool
+SessionSnapshot::append(const std::string& id, const std::string& payload) {
+  if (m_fd == -1 || id.size() != id_size)
+    return false;
+
+  record_header header{};
+  header.magic  = record_magic;
+  header.length = payload.size();
+  std::memcpy(header.id, id.data(), id_size);
+  header.checksum = checksum(header, payload.data());
+
+  // Write the record in one go so a crash leaves at most one torn
+  // record at the end, which open() cuts off.
+  std::string record(reinterpret_cast<const char*>(&header), sizeof(header));
+  record += payload;
+
+  if (!session_snapshot_write_all(
+        m_fd, record.data(), record.size(), m_fileSize)) {
+    ::ftruncate(m_fd, m_fileSize);
+    return false;
+  }
+
+  auto itr = m_index.find(id);
+
+  if (itr != m_index.end()) {
+    m_liveSize -= sizeof(record_header) + itr->second.length;
+    m_index.erase(itr);
+  }
+
+  if (!payload.empty()) {
+    m_index.emplace(id, entry_type{ m_fileSize, header.length });
+    m_liveSize += record.size();
+  }
+
+  m_fileSize += record.size();
+  return true;
+}
+
+bool
+SessionSnapshot::write(const std::string&     id,
+                       const torrent::Object& rtorrent,
+                       const torrent::Object& resume) {
+  std::ostringstream stream;
+
+  torrent::object_write_bencode(&stream, &rtorrent, 0);
+  torrent::object_write_bencode(&stream, &resume, 0);
+
+  if (!stream.good())
+    return false;
+
+  std::unique_lock<std::shared_mutex> lock(m_mutex);
+  return append(id, stream.str());
+}
+
+bool
+SessionSnapshot::erase(const std::string& id) {
+  std::unique_lock<std::shared_mutex> lock(m_mutex);
+
+  if (m_index.find(id) == m_index.end())
+    return true;
+
+  return append(id, std::string());
+}
+
+bool
+SessionSnapshot::sync() {
+  std::shared_lock<std::shared_mutex> lock(m_mutex);
+
+  return m_fd != -1 && ::fdatasync(m_fd) == 0;
+}
+
+bool
+SessionSnapshot::needs_compaction() const {
+  std::shared_lock<std::shared_mutex> lock(m_mutex);
+
+  uint64_t dead = m_fileSize - m_liveSize;
+  return dead >= compact_min_dead && dead > m_liveSize;
+}
+
+bool
+SessionSnapshot::compact() {
+  std::unique_lock<std::shared_mutex> lock(m_mutex);
+
+  if (m_fd == -1)
+    return false;
+
+  std::string tmp_path = m_path + ".new";
+  int fd =
+    ::open(tmp_path.c_str(), O_RDWR | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+
+  if (fd == -1)
+    return false;
+
+  index_type  index;
+  uint64_t    offset = 0;
+  std::string record;
+
+  for (const auto& itr : m_index) {
+    record.resize(sizeof(record_header));
+
+    std::string payload;
+
+    if (!read_payload(itr.second, &payload))
+      goto session_snapshot_compact_error;
+
+    record_header header{};
+    header.magic  = record_magic;
+    header.length = payload.size();
+    std::memcpy(header.id, itr.first.data(), id_size);
+    header.checksum = checksum(header, payload.data());
+
+    std::memcpy(&record[0], &header, sizeof(header));
+    record += payload;
+
+    if (!session_snapshot_write_all(fd, record.data(), record.size(), offset))
+      goto session_snapshot_compact_error;
+
+    index.emplace(itr.first, entry_type{ offset, header.length });
+    offset += record.size();
+  }
+
+  if (::fsync(fd) == -1 || ::rename(tmp_path.c_str(), m_path.c_str()) == -1)
+    goto session_snapshot_compact_error;
+
+  unmap_file();
+  ::close(m_fd);
+
+  m_fd = fd;
+  m_index.swap(index);
+  m_fileSize = offset;
+  m_liveSize = offset;
+
+  map_file();
+
+  // The rename is only durable once the directory is synced, the file
+  // in use is the compacted one either way.
+  return session_snapshot_sync_directory(m_path);
+
+session_snapshot_compact_error:
+  ::close(fd);
+  ::unlink(tmp_path.c_str());
+  return false;
+}
+
+size_t
+SessionSnapshot::size() const {
+  std::shared_lock<std::shared_mutex> lock(m_mutex);
+  return m_index.size();
+}
+
+uint64_t
+SessionSnapshot::file_size() const {
+  std::shared_lock<std::shared_mutex> lock(m_mutex);
+  return m_fileSize;
+}
+
+uint64_t
+SessionSnapshot::live_size() const {
+  std::shared_lock<std::shared_mutex> lock(m_mutex);
+  return m_liveSize;
+}
+
+}
@@ -0,0 +1,116 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+// Copyright (C) 2021, Contributors to the rTorrent project
+
+#include <csignal>
+#include <pthread.h>
+
+#include <torrent/utils/log.h>
+
+#include "core/session_writer.h"
+
+namespace core {
+
+SessionWriter::~SessionWriter() {
+  stop();
+}
+
+void
+SessionWriter::start() {
+  if (is_running())
+    return;
+
+  m_stop   = false;
+  m_thread = std::thread(&SessionWriter::run, this);
+}
+
+void
+SessionWriter::stop() {
+  if (!is_running())
+    return;
+
+  {
+    std::lock_guard<std::mutex> guard(m_lock);
+    m_stop = true;
+  }
+
+  m_condition.notify_all();
+  m_thread.join();
+}
+
+void
+SessionWriter::push(const std::string& id, size_t bytes, job_type job) {
+  if (!is_running()) {
+    m_busy++;
+    finished(id, job());
+    return;
+  }
+
+  std::unique_lock<std::mutex> lock(m_lock);
+
+  // A single job larger than the limit is let through once the queue
+  // is empty.
+  m_drained.wait(lock, [this, bytes] {
+    return m_jobs.empty() || m_queuedBytes + bytes <= max_queued_bytes;
+  });
+
+  m_busy++;
+  m_queuedBytes += bytes;
+  m_jobs.push_back(entry_type{ id, bytes, std::move(job) });
+
+  lock.unlock();
+  m_condition.notify_one();
+}
+
+bool
+SessionWriter::take_failed(const std::string& id) {
+  std::lock_guard<std::mutex> guard(m_lock);
+
+  return !m_failed.empty() && m_failed.erase(id) != 0;
+}
+
+void
+SessionWriter::finished(const std::string& id, bool success) {
+  if (!success) {
+    lt_log_print(torrent::LOG_ERROR,
+                 "Failed to save session torrent '%s'.",
+                 id.c_str());
+
+    m_failedJobs++;
+
+    std::lock_guard<std::mutex> guard(m_lock);
+    m_failed.insert(id);
+  }
+
+  m_busy--;
+}
+
+void
+SessionWriter::run() {
+  // Leave signal handling to the main thread.
+  sigset_t signals;
+  sigfillset(&signals);
+  pthread_sigmask(SIG_BLOCK, &signals, nullptr);
+
+  std::unique_lock<std::mutex> lock(m_lock);
+
+  while (true) {
+    m_condition.wait(lock, [this] { return !m_jobs.empty() || m_stop; });
+
+    if (m_jobs.empty())
+      return;
+
+    entry_type entry = std::move(m_jobs.front());
+    m_jobs.pop_front();
+
+    lock.unlock();
+    bool success = entry.job();
+    entry.job    = job_type();
+    finished(entry.id, success);
+    lock.lock();
+
+    m_queuedBytes -= entry.bytes;
+    m_drained.notify_all();
+  }
+}
+
+}
@@ -2,7 +2,10 @@
 // Copyright (C) 2005-2011, Jari Sundell <jaris@ifi.uio.no>
 
 #include <algorithm>
+#include <cstring>
 #include <functional>
+#include <memory>
+#include <numeric>
 #include <torrent/download.h>
 #include <torrent/exceptions.h>
 
@@ -16,10 +19,103 @@
 
 namespace core {
 
+ViewCommand::ViewCommand() = default;
+ViewCommand::~ViewCommand() = default;
+
+void
+ViewCommand::set(const torrent::Object& cmd) {
+  m_object = cmd;
+  m_command.reset();
+  m_sortKey.reset();
+}
+
+// Function objects are called with their arguments as-is, strings are
+// parsed the same way as 'parse_command_single' does.
+static rpc::parsed_command
+view_command_compile(const torrent::Object& cmd) {
+  if (!cmd.is_dict_key())
+    return rpc::parse_command_compile(cmd.as_string());
+
+  rpc::parsed_command result;
+  result.itr = rpc::commands.find(cmd.as_dict_key().c_str());
+
+  if (result.itr == rpc::commands.end())
+    throw torrent::input_error("Command \"" + cmd.as_dict_key() +
+                               "\" does not exist.");
+
+  result.args = cmd.as_dict_obj();
+  return result;
+}
+
+void
+ViewCommand::resolve() const {
+  if (m_command != nullptr && m_generation == rpc::commands.generation())
+    return;
+
+  m_command.reset();
+  m_sortKey.reset();
+  m_sortOrder = sort_none;
+
+  auto command = std::make_unique<rpc::parsed_command>(
+    view_command_compile(m_object));
+
+  // Look for 'less' or 'greater' with a single getter, which is what
+  // 'apply_cmp' calls on each side of the download pair.
+  if (command->itr != rpc::commands.end() && !command->execute) {
+    const torrent::Object* getter = &command->args;
+
+    if (getter->is_list() && getter->as_list().size() == 1)
+      getter = &getter->as_list().front();
+
+    bool is_less    = std::strcmp(command->itr->first, "less") == 0;
+    bool is_greater = std::strcmp(command->itr->first, "greater") == 0;
+
+    if ((is_less || is_greater) &&
+        (getter->is_dict_key() || getter->is_string())) {
+      try {
+        m_sortKey = std::make_unique<rpc::parsed_command>(
+          view_command_compile(*getter));
+        m_sortOrder = is_less ? sort_less : sort_greater;
+      } catch (torrent::input_error& e) {
+        // Leave reporting the error to the comparison.
+      }
+    }
+  }
+
+  m_command    = std::move(command);
+  m_generation = rpc::commands.generation();
+}
+
+torrent::Object
+ViewCommand::call(rpc::target_type target) const {
+  resolve();
+  return rpc::call_parsed_command(*m_command, target);
+}
+
+ViewCommand::sort_type
+ViewCommand::sort_order() const {
+  if (m_object.is_empty())
+    return sort_none;
+
+  resolve();
+  return m_sortOrder;
+}
+
+torrent::Object
+ViewCommand::call_sort_key(Download* download) const {
+  resolve();
+
+  if (m_sortKey == nullptr)
+    throw torrent::internal_error(
+      "ViewCommand::call_sort_key(...) called without a sort key.");
+
+  return rpc::call_parsed_command(*m_sortKey, rpc::make_target(download));
+}
+
 // Also add focus thingie here?
 struct view_downloads_compare
   : std::binary_function<Download*, Download*, bool> {
-  view_downloads_compare(const torrent::Object& cmd)
+  view_downloads_compare(const ViewCommand& cmd)
     : m_command(cmd) {}
 
   bool operator()(Download* d1, Download* d2) const {
@@ -27,29 +123,7 @@ struct view_downloads_compare
       if (m_command.is_empty())
         return false;
 
-      if (!m_command.is_dict_key())
-        return rpc::parse_command_single(rpc::make_target_pair(d1, d2),
-                                         m_command.as_string())
-          .as_value();
-
-      // torrent::Object tmp_command = m_command;
-
-      // uint32_t flags = tmp_command.flags() & torrent::Object::mask_function;
-      // tmp_command.unset_flags(torrent::Object::mask_function);
-      // tmp_command.set_flags((flags >> 1) & torrent::Object::mask_function);
-
-      // rpc::parse_command_execute(rpc::make_target_pair(d1, d2),
-      // &tmp_command); return
-      // rpc::commands.call_command(tmp_command.as_dict_key().c_str(),
-      // tmp_command.as_dict_obj(),
-      //                                   rpc::make_target_pair(d1,
-      //                                   d2)).as_value();
-
-      return rpc::commands
-        .call_command(m_command.as_dict_key().c_str(),
-                      m_command.as_dict_obj(),
-                      rpc::make_target_pair(d1, d2))
-        .as_value();
+      return m_command.call(rpc::make_target_pair(d1, d2)).as_value();
 
     } catch (torrent::input_error& e) {
       control->core()->push_log(e.what());
@@ -58,11 +132,11 @@ struct view_downloads_compare
     }
   }
 
-  const torrent::Object& m_command;
+  const ViewCommand& m_command;
 };
 
 struct view_downloads_filter : std::unary_function<Download*, bool> {
-  view_downloads_filter(const torrent::Object& cmd, const torrent::Object& cmd2)
+  view_downloads_filter(const ViewCommand& cmd, const ViewCommand& cmd2)
     : m_command(cmd)
     , m_command2(cmd2) {}
 
@@ -70,34 +144,12 @@ struct view_downloads_filter : std::unary_function<Download*, bool> {
     return this->evalCmd(m_command, d1) && this->evalCmd(m_command2, d1);
   }
 
-  bool evalCmd(const torrent::Object& cmd, Download* d1) const {
+  bool evalCmd(const ViewCommand& cmd, Download* d1) const {
     if (cmd.is_empty())
       return true;
 
     try {
-      torrent::Object result;
-
-      if (cmd.is_dict_key()) {
-        // torrent::Object tmp_command = cmd;
-
-        // uint32_t flags = tmp_command.flags() &
-        // torrent::Object::mask_function;
-        // tmp_command.unset_flags(torrent::Object::mask_function);
-        // tmp_command.set_flags((flags >> 1) & torrent::Object::mask_function);
-
-        // rpc::parse_command_execute(rpc::make_target(d1), &tmp_command);
-        // result =
-        // rpc::commands.call_command(tmp_command.as_dict_key().c_str(),
-        // tmp_command.as_dict_obj(),
-        //                                     rpc::make_target(d1));
-
-        result = rpc::commands.call_command(
-          cmd.as_dict_key().c_str(), cmd.as_dict_obj(), rpc::make_target(d1));
-
-      } else {
-        result =
-          rpc::parse_command_single(rpc::make_target(d1), cmd.as_string());
-      }
+      torrent::Object result = cmd.call(rpc::make_target(d1));
 
       switch (result.type()) {
           //      case torrent::Object::TYPE_RAW_BENCODE: return
@@ -125,10 +177,61 @@ struct view_downloads_filter : std::unary_function<Download*, bool> {
     }
   }
 
-  const torrent::Object& m_command;
-  const torrent::Object& m_command2;
+  const ViewCommand& m_command;
+  const ViewCommand& m_command2;
 };
 
+// Returns an empty object if the command has no sort key, or calling it
+// failed.
+static torrent::Object
+view_sort_key(const ViewCommand& cmd, Download* download) {
+  try {
+    if (cmd.sort_order() == ViewCommand::sort_none)
+      return torrent::Object();
+
+    return cmd.call_sort_key(download);
+
+  } catch (torrent::input_error& e) {
+    return torrent::Object();
+  }
+}
+
+static ViewCommand::sort_type
+view_sort_order(const ViewCommand& cmd) {
+  try {
+    return cmd.sort_order();
+  } catch (torrent::input_error& e) {
+    return ViewCommand::sort_none;
+  }
+}
+
+static bool
+view_sort_key_is_valid(const torrent::Object& key) {
+  return key.is_value() || key.is_string();
+}
+
+// Orders keys of the same type as 'apply_less' and 'apply_greater'.
+static bool
+view_sort_key_compare(ViewCommand::sort_type  order,
+                      const torrent::Object& key1,
+                      const torrent::Object& key2) {
+  int result = key1.is_value()
+                 ? (key1.as_value() > key2.as_value()) -
+                     (key1.as_value() < key2.as_value())
+                 : key1.as_string().compare(key2.as_string());
+
+  return order == ViewCommand::sort_less ? result < 0 : result > 0;
+}
+
+static bool
+view_sort_key_equal(ViewCommand::sort_type  order,
+                    const torrent::Object& key1,
+                    const torrent::Object& key2) {
+  return view_sort_key_is_valid(key1) && key1.type() == key2.type() &&
+         !view_sort_key_compare(order, key1, key2) &&
+         !view_sort_key_compare(order, key2, key1);
+}
+
 void
 View::emit_changed() {
   priority_queue_erase(&taskScheduler, &m_delayChanged);
@@ -150,6 +253,7 @@ View::~View() {
 
   clear_filter_on();
   priority_queue_erase(&taskScheduler, &m_delayChanged);
+  priority_queue_erase(&taskScheduler, &m_delayDirty);
 }
 
 void
@@ -169,57 +273,65 @@ View::initialize(const std::string& name) {
   // Urgh, wrong. No filtering being done.
   for (const auto& download : *dlist) {
     push_back(download);
+    m_index[download].visible = true;
   }
 
   m_size  = base_type::size();
   m_focus = 0;
 
-  set_last_changed(torrent::utils::timer());
   m_delayChanged.slot() = [this] { emit_changed_now(); };
+  m_delayDirty.slot()   = [this] { update_dirty(); };
+
+  set_last_changed(torrent::utils::timer());
 }
 
 void
 View::erase(Download* download) {
-  iterator itr = std::find(base_type::begin(), base_type::end(), download);
+  auto index_itr = m_index.find(download);
 
-  if (itr >= end_visible()) {
-    erase_internal(itr);
+  if (index_itr == m_index.end())
+    throw torrent::internal_error("View::erase(...) could not find download.");
 
-  } else {
-    erase_internal(itr);
+  bool visible = index_itr->second.visible;
+
+  erase_internal(visible ? find_visible(download) : find_filtered(download));
+  m_index.erase(index_itr);
+
+  if (visible)
     rpc::call_object_nothrow(m_event_removed, rpc::make_target(download));
-  }
 }
 
 void
 View::set_visible(Download* download) {
-  iterator itr = std::find(begin_filtered(), end_filtered(), download);
+  auto index_itr = m_index.find(download);
 
-  if (itr == end_filtered())
+  if (index_itr == m_index.end() || index_itr->second.visible)
     return;
 
   // Don't optimize erase since we want to keep the order of the
   // non-visible elements.
-  base_type::erase(itr);
-  insert_visible(download);
+  base_type::erase(find_filtered(download));
+  insert_visible(download, view_sort_key(m_sortNew, download));
 
   rpc::call_object_nothrow(m_event_added, rpc::make_target(download));
 }
 
 void
 View::set_not_visible(Download* download) {
-  iterator itr = std::find(begin_visible(), end_visible(), download);
+  auto index_itr = m_index.find(download);
 
-  if (itr == end_visible())
+  if (index_itr == m_index.end() || !index_itr->second.visible)
     return;
 
+  iterator itr = find_visible(download);
+
   m_size--;
   m_focus -= (m_focus > position(itr));
 
   // Don't optimize erase since we want to keep the order of the
   // non-visible elements.
   base_type::erase(itr);
-  base_type::push_back(download);
+  push_filtered(download, index_itr->second);
 
   rpc::call_object_nothrow(m_event_removed, rpc::make_target(download));
 }
@@ -250,18 +362,72 @@ View::sort() {
 
   Download* curFocus = focus() != end_visible() ? *focus() : nullptr;
 
+  // The keys are only fresh for placing new downloads if both sorts
+  // use the same command.
+  bool same_sort = m_sortCurrent.object().is_string() &&
+                   m_sortNew.object().is_string() &&
+                   m_sortCurrent.object().as_string() ==
+                     m_sortNew.object().as_string();
+
   // Don't go randomly switching around equivalent elements.
-  std::stable_sort(
-    begin(), end_visible(), view_downloads_compare(m_sortCurrent));
+  if (!sort_by_key(m_sortCurrent, same_sort))
+    std::stable_sort(
+      begin(), end_visible(), view_downloads_compare(m_sortCurrent));
+
+  update_sorted_by_key();
 
   m_focus = position(std::find(begin(), end_visible(), curFocus));
   emit_changed();
 }
 
+// Sorts the visible downloads on keys called once for each download,
+// instead of calling the comparison for each pair. Returns false if
+// the command isn't a simple comparison or the keys aren't all values
+// or all strings, leaving it to the comparison to handle.
+bool
+View::sort_by_key(const ViewCommand& cmd, bool store_keys) {
+  ViewCommand::sort_type order = view_sort_order(cmd);
+
+  if (order == ViewCommand::sort_none || m_size < 2)
+    return false;
+
+  std::vector<torrent::Object> keys;
+  keys.reserve(m_size);
+
+  for (iterator itr = begin_visible(); itr != end_visible(); ++itr) {
+    keys.push_back(view_sort_key(cmd, *itr));
+
+    if ((!keys.back().is_value() && !keys.back().is_string()) ||
+        keys.back().type() != keys.front().type())
+      return false;
+  }
+
+  std::vector<uint32_t> indices(m_size);
+  std::iota(indices.begin(), indices.end(), 0);
+
+  std::stable_sort(
+    indices.begin(), indices.end(), [&keys, order](uint32_t a, uint32_t b) {
+      return view_sort_key_compare(order, keys[a], keys[b]);
+    });
+
+  base_type sorted;
+  sorted.reserve(m_size);
+
+  for (uint32_t index : indices)
+    sorted.push_back(*(begin() + index));
+
+  if (store_keys)
+    for (uint32_t i = 0; i < m_size; i++)
+      m_index[*(begin() + i)].key = std::move(keys[i]);
+
+  std::copy(sorted.begin(), sorted.end(), begin());
+  return true;
+}
+
 void
 View::filter() {
   // Do NOT allow filter STARTED and STOPPED views: they are special
-  if (m_name == "started" || m_name == "stopped")
+  if (is_filter_fixed())
     return;
 
   // Parition the list in two steps so we know which elements changed.
@@ -285,6 +451,24 @@ View::filter() {
   // Fix this...
   m_focus = std::min(m_focus, m_size);
 
+  // Keys of filtered downloads aren't kept up to date. The newly
+  // filtered downloads were placed before the others, so the filtered
+  // part is numbered again.
+  for (iterator itr = changed.begin(); itr != splitChanged; ++itr)
+    m_index[*itr].visible = false;
+
+  if (changed.begin() != splitChanged)
+    for (iterator itr = begin_filtered(); itr != end_filtered(); ++itr)
+      m_index[*itr].sequence = ++m_sequence;
+
+  for (iterator itr = splitChanged; itr != changed.end(); ++itr) {
+    index_entry& entry = m_index[*itr];
+    entry.visible      = true;
+    entry.key          = view_sort_key(m_sortNew, *itr);
+  }
+
+  update_sorted_by_key();
+
   // The commands are allowed to remove itself from or change View
   // sorting since the commands are being called on the 'changed'
   // vector. But this will cause undefined behavior if elements are
@@ -310,12 +494,24 @@ View::filter() {
   emit_changed();
 }
 
+void
+View::refresh() {
+  // Everything is filtered again, so the downloads marked so far don't
+  // need another pass.
+  clear_dirty();
+
+  filter();
+  sort();
+
+  m_lastRefresh = cachedTime;
+}
+
 void
 View::filter_by(const torrent::Object& condition, View::base_type& result) {
-  // std::copy_if(begin_visible(), end_visible(), result.begin(),
-  // view_downloads_filter(condition));
-  view_downloads_filter matches =
-    view_downloads_filter(condition, m_temp_filter);
+  ViewCommand command;
+  command.set(condition);
+
+  view_downloads_filter matches = view_downloads_filter(command, m_temp_filter);
 
   for (iterator itr = begin_visible(); itr != end_visible(); ++itr)
     if (matches(*itr))
@@ -324,44 +520,115 @@ View::filter_by(const torrent::Object& condition, View::base_type& result) {
 
 void
 View::filter_download(core::Download* download) {
-  iterator itr = std::find(base_type::end() - 1, base_type::end(), download);
+  if (refilter_download(download, true))
+    emit_changed();
+}
 
-  if (itr == base_type::end()) {
-    itr = std::find(base_type::begin(), base_type::end() - 1, download);
-  }
+// Returns false if the download stays filtered. Unless the visible
+// downloads are in the order of their cached keys, a download that
+// stays visible is only placed again if 'place_unsorted' is set.
+bool
+View::refilter_download(Download* download, bool place_unsorted) {
+  bool matches = view_downloads_filter(m_filter, m_temp_filter)(download);
+
+  // Looked up after calling the filter, which may change the view.
+  auto index_itr = m_index.find(download);
 
-  if (itr == base_type::end()) {
+  if (index_itr == m_index.end()) {
     throw torrent::internal_error(
       "View::filter_download(...) could not find download.");
   }
 
-  if (view_downloads_filter(m_filter, m_temp_filter)(download)) {
-    if (itr >= end_visible()) {
-      erase_internal(itr);
-      insert_visible(download);
+  if (matches) {
+    if (!index_itr->second.visible) {
+      erase_internal(find_filtered(download));
+      insert_visible(download, view_sort_key(m_sortNew, download));
 
       rpc::call_object_nothrow(m_event_added, rpc::make_target(download));
+      return true;
+    }
 
-    } else {
-      // This makes sure the download is sorted even if it is
-      // already visible.
-      //
-      // Consider removing this.
-      erase_internal(itr);
-      insert_visible(download);
+    if (!m_sortedByKey && !place_unsorted)
+      return true;
+
+    // This makes sure the download is sorted even if it is
+    // already visible.
+    //
+    // Consider removing this.
+    torrent::Object key = view_sort_key(m_sortNew, download);
+
+    if (!m_sortedByKey ||
+        !view_sort_key_equal(
+          view_sort_order(m_sortNew), key, index_itr->second.key)) {
+      erase_internal(find_visible(download));
+      insert_visible(download, std::move(key));
     }
 
-  } else {
-    if (itr >= end_visible())
-      return;
+    return true;
+  }
 
-    erase_internal(itr);
-    base_type::push_back(download);
+  if (!index_itr->second.visible)
+    return false;
 
-    rpc::call_object_nothrow(m_event_removed, rpc::make_target(download));
+  erase_internal(find_visible(download));
+  push_filtered(download, index_itr->second);
+
+  rpc::call_object_nothrow(m_event_removed, rpc::make_target(download));
+  return true;
+}
+
+void
+View::mark_dirty(Download* download) {
+  auto index_itr = m_index.find(download);
+
+  if (index_itr == m_index.end() || index_itr->second.dirty)
+    return;
+
+  index_itr->second.dirty = true;
+  m_dirty.push_back(download);
+
+  if (!m_delayDirty.is_queued() && !m_name.empty())
+    priority_queue_insert(&taskScheduler, &m_delayDirty, cachedTime);
+}
+
+void
+View::update_dirty() {
+  priority_queue_erase(&taskScheduler, &m_delayDirty);
+
+  base_type dirty;
+  dirty.swap(m_dirty);
+
+  bool changed = false;
+
+  for (Download* download : dirty) {
+    // Erased downloads are left in the list.
+    auto index_itr = m_index.find(download);
+
+    if (index_itr == m_index.end() || !index_itr->second.dirty)
+      continue;
+
+    index_itr->second.dirty = false;
+
+    if (!is_filter_fixed())
+      changed |= refilter_download(download, false);
   }
 
-  emit_changed();
+  if (changed)
+    emit_changed();
+}
+
+void
+View::clear_dirty() {
+  priority_queue_erase(&taskScheduler, &m_delayDirty);
+
+  for (Download* download : m_dirty) {
+    auto index_itr = m_index.find(download);
+
+    if (index_itr != m_index.end())
+      index_itr->second.dirty = false;
+  }
+
+  m_dirty.clear();
 }
 
 void
@@ -376,14 +643,49 @@ View::clear_filter_on() {
 }
 
 inline void
-View::insert_visible(Download* d) {
-  iterator itr =
-    m_sortNew.is_empty()
-      ? end_visible()
-      : std::find_if(
-          begin_visible(), end_visible(), [d, this](Download* download) {
-            return view_downloads_compare(m_sortNew)(d, download);
-          });
+View::insert_visible(Download* d, torrent::Object key) {
+  iterator itr = end_visible();
+
+  if (!m_sortNew.is_empty()) {
+    ViewCommand::sort_type order = view_sort_key_is_valid(key)
+                                     ? view_sort_order(m_sortNew)
+                                     : ViewCommand::sort_none;
+
+    if (order != ViewCommand::sort_none &&
+        (m_size == 0 ||
+         (m_sortedByKey && cached_key(*begin()).type() == key.type()))) {
+      itr = std::upper_bound(
+        begin_visible(),
+        end_visible(),
+        key,
+        [this, order](const torrent::Object& value, Download* download) {
+          return view_sort_key_compare(order, value, cached_key(download));
+        });
+
+      m_sortedByKey = true;
+
+    } else {
+      // Keys that can't be compared directly go through the
+      // comparison.
+      itr = std::find_if(
+        begin_visible(), end_visible(), [&](Download* download) {
+          if (order != ViewCommand::sort_none) {
+            const torrent::Object& other = cached_key(download);
+
+            if (other.type() == key.type())
+              return view_sort_key_compare(order, key, other);
+          }
+
+          return view_downloads_compare(m_sortNew)(d, download);
+        });
+
+      m_sortedByKey = false;
+    }
+  }
+
+  index_entry& entry = m_index[d];
+  entry.visible      = true;
+  entry.key          = std::move(key);
 
   m_size++;
   m_focus += (m_focus >= position(itr));
@@ -391,6 +693,92 @@ View::insert_visible(Download* d) {
   base_type::insert(itr, d);
 }
 
+// Binary searches the cached keys if the visible downloads are sorted
+// on them, falling back to a linear search.
+View::iterator
+View::find_visible(Download* d) {
+  const torrent::Object& key = cached_key(d);
+
+  if (m_sortedByKey && view_sort_key_is_valid(key)) {
+    ViewCommand::sort_type order = view_sort_order(m_sortNew);
+
+    iterator itr = std::lower_bound(
+      begin_visible(),
+      end_visible(),
+      key,
+      [this, order](Download* download, const torrent::Object& value) {
+        return view_sort_key_compare(order, cached_key(download), value);
+      });
+
+    for (; itr != end_visible() &&
+           !view_sort_key_compare(order, key, cached_key(*itr));
+         ++itr)
+      if (*itr == d)
+        return itr;
+  }
+
+  return std::find(begin_visible(), end_visible(), d);
+}
+
+// Binary searches the sequence numbers of the filtered downloads.
+View::iterator
+View::find_filtered(Download* d) {
+  iterator itr = std::lower_bound(
+    begin_filtered(),
+    end_filtered(),
+    sequence(d),
+    [this](Download* download, uint64_t value) {
+      return sequence(download) < value;
+    });
+
+  return itr != end_filtered() && *itr == d ? itr : end_filtered();
+}
+
+void
+View::update_sorted_by_key() {
+  ViewCommand::sort_type order = view_sort_order(m_sortNew);
+
+  m_sortedByKey = false;
+
+  if (order == ViewCommand::sort_none)
+    return;
+
+  for (iterator itr = begin_visible(); itr != end_visible(); ++itr) {
+    const torrent::Object& key = cached_key(*itr);
+
+    if (!view_sort_key_is_valid(key))
+      return;
+
+    if (itr != begin_visible()) {
+      const torrent::Object& prev = cached_key(*(itr - 1));
+
+      if (prev.type() != key.type() ||
+          view_sort_key_compare(order, key, prev))
+        return;
+    }
+  }
+
+  m_sortedByKey = true;
+}
+
+void
+View::set_sort_new(const torrent::Object& s) {
+  m_sortNew.set(s);
+
+  for (auto& entry : m_index)
+    entry.second.key = torrent::Object();
+
+  m_sortedByKey = false;
+}
+
+void
+View::push_filtered(Download* d, index_entry& entry) {
+  entry.visible  = false;
+  entry.sequence = ++m_sequence;
+
+  base_type::push_back(d);
+}
+
 inline void
 View::erase_internal(iterator itr) {
   if (itr == end_filtered())
@@ -59,16 +59,28 @@ ViewManager::find_throw(const std::string& name) {
 
 void
 ViewManager::sort(const std::string& name, uint32_t timeout) {
-  iterator viewItr = find_throw(name);
+  View* view = *find_throw(name);
 
-  if ((*viewItr)->last_changed() +
-        torrent::utils::timer::from_seconds(timeout) >
+  if (view->last_changed() + torrent::utils::timer::from_seconds(timeout) >
       cachedTime)
     return;
 
+  if (timeout != 0 &&
+      view->last_refresh() +
+          torrent::utils::timer::from_seconds(m_refreshInterval) >
+        cachedTime) {
+    view->update_dirty();
+    return;
+  }
+
   // Should we rename sort, or add a seperate function?
-  (*viewItr)->filter();
-  (*viewItr)->sort();
+  view->refresh();
+}
+
+void
+ViewManager::mark_dirty(Download* download) {
+  for (const auto& view : *this)
+    view->mark_dirty(download);
 }
 
 void
@@ -0,0 +1,276 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+// Copyright (C) 2021, Contributors to the rTorrent project
+
+#include <algorithm>
+#include <dirent.h>
+#include <sys/inotify.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <torrent/exceptions.h>
+#include <torrent/poll.h>
+#include <torrent/utils/error_number.h>
+#include <torrent/utils/log.h>
+#include <torrent/utils/path.h>
+
+#include "core/watch_directories.h"
+#include "utils/directory.h"
+
+#include "globals.h"
+
+namespace core {
+
+// Files are picked up once closed after writing or moved in, while
+// IN_CREATE is only acted on for directories.
+static constexpr uint32_t watch_directories_mask =
+  IN_CLOSE_WRITE | IN_MOVED_TO | IN_CREATE | IN_ONLYDIR;
+
+static bool
+watch_directories_is_dir(const utils::directory_entry& entry,
+                         const std::string&            path) {
+  if (entry.d_type != DT_UNKNOWN)
+    return entry.d_type == DT_DIR;
+
+  // Symlinked directories aren't followed, which also keeps loops out.
+  struct stat s;
+  return ::lstat(path.c_str(), &s) == 0 && S_ISDIR(s.st_mode);
+}
+
+WatchDirectories::WatchDirectories() {
+  m_fileDesc            = -1;
+  m_taskDebounce.slot() = [this] { receive_debounce(); };
+}
+
+WatchDirectories::~WatchDirectories() {
+  priority_queue_erase(&taskScheduler, &m_taskDebounce);
+
+  if (is_open())
+    ::close(m_fileDesc);
+}
+
+bool
+WatchDirectories::open(torrent::Poll* poll) {
+  if (is_open())
+    return true;
+
+  m_fileDesc = ::inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+
+  if (m_fileDesc == -1)
+    return false;
+
+  m_poll = poll;
+  m_poll->open(this);
+  m_poll->insert_read(this);
+  m_poll->insert_error(this);
+  return true;
+}
+
+void
+WatchDirectories::close() {
+  if (!is_open())
+    return;
+
+  m_poll->remove_read(this);
+  m_poll->remove_error(this);
+  m_poll->close(this);
+
+  ::close(m_fileDesc);
+  m_fileDesc = -1;
+  m_poll     = nullptr;
+
+  priority_queue_erase(&taskScheduler, &m_taskDebounce);
+
+  m_roots.clear();
+  m_watches.clear();
+  m_pending.clear();
+}
+
+void
+WatchDirectories::insert(const std::string& path,
+                         int                flags,
+                         slot_string        slot) {
+  if (!is_open())
+    throw torrent::internal_error("WatchDirectories::insert() not open.");
+
+  std::string expanded = torrent::utils::path_expand(path);
+
+  while (expanded.size() > 1 && expanded.back() == '/')
+    expanded.pop_back();
+
+  auto root = std::find_if(m_roots.begin(),
+                           m_roots.end(),
+                           [&expanded](const root_type& r) {
+                             return r.path == expanded;
+                           }) -
+              m_roots.begin();
+
+  if ((size_t)root == m_roots.size())
+    m_roots.push_back(root_type{ expanded, flags, std::move(slot) });
+  else
+    m_roots[root] = root_type{ expanded, flags, std::move(slot) };
+
+  if (!add_directory(expanded, root, m_scanExisting))
+    throw torrent::input_error(
+      "Could not watch directory '" + path +
+      "': " + torrent::utils::error_number::current().message());
+}
+
+bool
+WatchDirectories::is_torrent_file(const std::string& name) {
+  static const std::string suffix = ".torrent";
+
+  return name.size() > suffix.size() && name.front() != '.' &&
+         name.compare(name.size() - suffix.size(), suffix.size(), suffix) == 0;
+}
+
+// Watches 'path' before listing it, so files added in between are
+// seen by at least one of the two. The '.torrent' files found are only
+// queued if 'scan' is set, subdirectories are listed either way.
+bool
+WatchDirectories::add_directory(const std::string& path,
+                                size_t             root,
+                                bool               scan) {
+  int wd =
+    ::inotify_add_watch(m_fileDesc, path.c_str(), watch_directories_mask);
+
+  if (wd == -1)
+    return false;
+
+  m_watches[wd] = watch_type{ path, root };
+
+  utils::Directory directory(path);
+
+  if (!directory.update(utils::Directory::update_hide_dot))
+    return true;
+
+  for (const auto& entry : directory) {
+    std::string child = path + '/' + entry.d_name;
+
+    if (watch_directories_is_dir(entry, child)) {
+      if ((m_roots[root].flags & flag_recursive) &&
+          !add_directory(child, root, scan))
+        lt_log_print(torrent::LOG_NOTICE,
+                     "watch directories: could not watch '%s': %s",
+                     child.c_str(),
+                     torrent::utils::error_number::current().message().c_str());
+
+    } else if (scan && is_torrent_file(entry.d_name)) {
+      queue(child, root);
+    }
+  }
+
+  return true;
+}
+
+void
+WatchDirectories::queue(const std::string& path, size_t root) {
+  pending_type& entry = m_pending[path];
+
+  entry.deadline =
+    cachedTime + torrent::utils::timer::from_seconds(m_debounce);
+  entry.root = root;
+
+  // Deadlines only move forward, so the queued task fires early at
+  // worst and reschedules itself.
+  if (!m_taskDebounce.is_queued())
+    priority_queue_insert(&taskScheduler, &m_taskDebounce, entry.deadline);
+}
+
+void
+WatchDirectories::receive_debounce() {
+  std::vector<std::pair<std::string, size_t>> ready;
+  torrent::utils::timer                       next;
+
+  for (auto itr = m_pending.begin(); itr != m_pending.end();) {
+    if (itr->second.deadline > cachedTime) {
+      if (next == torrent::utils::timer() || itr->second.deadline < next)
+        next = itr->second.deadline;
+
+      ++itr;
+      continue;
+    }
+
+    ready.emplace_back(itr->first, itr->second.root);
+    itr = m_pending.erase(itr);
+  }
+
+  if (!m_pending.empty())
+    priority_queue_insert(&taskScheduler, &m_taskDebounce, next);
+
+  for (const auto& [path, root] : ready) {
+    // A slot may close the watches, clearing m_roots, or insert more
+    // directories, moving it.
+    if (!is_open() || root >= m_roots.size())
+      return;
+
+    slot_string slot = m_roots[root].slot;
+    slot(path);
+  }
+}
+
+void
+WatchDirectories::event_read() {
+  alignas(inotify_event) char buffer[16 * 1024];
+
+  while (true) {
+    ssize_t length = ::read(m_fileDesc, buffer, sizeof(buffer));
+
+    if (length <= 0)
+      return;
+
+    for (char* itr = buffer; itr < buffer + length;) {
+      const inotify_event* event = reinterpret_cast<inotify_event*>(itr);
+      itr += sizeof(inotify_event) + event->len;
+
+      // Events were dropped. Subdirectories created meanwhile are
+      // watched, but the files already queued or loaded aren't
+      // reported again.
+      if (event->mask & IN_Q_OVERFLOW) {
+        lt_log_print(torrent::LOG_NOTICE,
+                     "watch directories: event queue overflow, files added "
+                     "meanwhile may be missed");
+
+        for (size_t root = 0; root < m_roots.size(); root++)
+          if (m_roots[root].flags & flag_recursive)
+            add_directory(m_roots[root].path, root, false);
+
+        continue;
+      }
+
+      auto watch_itr = m_watches.find(event->wd);
+
+      if (watch_itr == m_watches.end())
+        continue;
+
+      if (event->mask & IN_IGNORED) {
+        m_watches.erase(watch_itr);
+        continue;
+      }
+
+      if (event->len == 0)
+        continue;
+
+      std::string path = watch_itr->second.path + '/' + event->name;
+      size_t      root = watch_itr->second.root;
+
+      if (event->mask & IN_ISDIR) {
+        // Files in a directory created or moved in are all new.
+        if ((event->mask & (IN_CREATE | IN_MOVED_TO)) &&
+            (m_roots[root].flags & flag_recursive))
+          add_directory(path, root, true);
+
+      } else if ((event->mask & (IN_CLOSE_WRITE | IN_MOVED_TO)) &&
+                 is_torrent_file(event->name)) {
+        queue(path, root);
+      }
+    }
+  }
+}
+
+void
+WatchDirectories::event_write() {}
+
+void
+WatchDirectories::event_error() {}
+
+}
@@ -5,6 +5,7 @@
 
 #include "buildinfo.h"
 
+#include <chrono>
 #include <cstdint>
 #include <cstdio>
 #include <cstdlib>
@@ -35,6 +36,7 @@
 #include "core/download_factory.h"
 #include "core/download_store.h"
 #include "core/manager.h"
+#include "core/session_loader.h"
 #include "core/view_manager.h"
 #include "display/canvas.h"
 #include "display/manager.h"
@@ -141,17 +143,27 @@ load_session_torrents() {
     }
   }
 
+  // We don't really support session torrents that are links. These
+  // would be overwritten anyway on exit, and thus not really be
+  // useful.
+  core::SessionLoader::path_list paths;
+
   for (const auto& entry : entries) {
-    // We don't really support session torrents that are links. These
-    // would be overwritten anyway on exit, and thus not really be
-    // useful.
-    if (!entry.is_file()) {
-      if (progress_bar != nullptr) {
-        progress_bar->tick();
-      }
-      continue;
+    if (entry.is_file()) {
+      paths.push_back(entries.path() + entry.d_name);
+    } else if (progress_bar != nullptr) {
+      progress_bar->tick();
     }
+  }
+
+  using clock_type = std::chrono::steady_clock;
 
+  auto                started = clock_type::now();
+  core::SessionLoader loader(
+    std::move(paths), 0, control->core()->download_store()->snapshot());
+  core::SessionEntry  session_entry;
+
+  while (loader.next(&session_entry)) {
     core::DownloadFactory* f = new core::DownloadFactory(control->core());
 
     // Replace with session torrent flag.
@@ -170,10 +182,12 @@ load_session_torrents() {
       delete f;
     });
 
-    f->load(entries.path() + entry.d_name);
+    f->load_session(std::move(session_entry));
     f->commit();
   }
 
+  auto loaded = clock_type::now();
+
   // Hash torrents
   if (progress_bar != nullptr) {
     progress_bar->set_option(indicators::option::PostfixText{ "Checking" });
@@ -191,6 +205,32 @@ load_session_torrents() {
     progress_bar->mark_as_completed();
     delete progress_bar;
   }
+
+  if (entries_size == 0)
+    return;
+
+  auto to_ms = [](clock_type::duration d) {
+    return std::chrono::duration_cast<std::chrono::milliseconds>(d).count();
+  };
+
+  auto wait_ms = (long long)(loader.wait_seconds() * 1000);
+
+  char buffer[256];
+  snprintf(buffer,
+           sizeof(buffer),
+           "Loaded %zu session torrents with %u threads: read %lld ms "
+           "(summed), waited %lld ms, committed %lld ms, hashing setup %lld ms",
+           entries_size,
+           loader.threads(),
+           (long long)(loader.read_seconds() * 1000),
+           wait_ms,
+           (long long)to_ms(loaded - started) - wait_ms,
+           (long long)to_ms(clock_type::now() - loaded));
+
+  lt_log_print(torrent::LOG_SYSTEM, "system: %s", buffer);
+
+  if (!display::Canvas::isInitialized())
+    std::cout << "rTorrent: " << buffer << std::endl;
 }
 
 void
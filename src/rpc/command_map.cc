@@ -1,6 +1,9 @@
 // SPDX-License-Identifier: GPL-2.0-or-later
 // Copyright (C) 2005-2011, Jari Sundell <jaris@ifi.uio.no>
 
+#include <algorithm>
+#include <cstring>
+
 #include <torrent/data/file_list_iterator.h>
 #include <torrent/exceptions.h>
 #include <torrent/object.h>
@@ -19,7 +22,7 @@
 
 namespace rpc {
 
-command_base::stack_type command_base::current_stack;
+thread_local command_base::stack_type command_base::current_stack;
 
 CommandMap::~CommandMap() {
   std::vector<const char*> keys;
@@ -39,11 +42,94 @@ CommandMap::~CommandMap() {
     delete[] * itr;
 }
 
+// FNV-1a, the keys are short and mostly share their prefixes.
+size_t
+CommandMap::hash_key(const char* key) {
+  size_t hash = 14695981039346656037ULL;
+
+  while (*key != '\0')
+    hash = (hash ^ (unsigned char)*key++) * 1099511628211ULL;
+
+  return hash;
+}
+
+const CommandMap::index_entry*
+CommandMap::index_find(const char* key) const {
+  if (m_index.empty())
+    return nullptr;
+
+  size_t hash = hash_key(key);
+  size_t mask = m_index.size() - 1;
+
+  for (size_t i = hash & mask; m_index[i].used; i = (i + 1) & mask)
+    if (m_index[i].hash == hash && std::strcmp(m_index[i].itr->first, key) == 0)
+      return &m_index[i];
+
+  return nullptr;
+}
+
+void
+CommandMap::index_insert(iterator itr) {
+  if (2 * (base_type::size() + 1) > m_index.size()) {
+    std::vector<index_entry> old_index(std::max<size_t>(m_index.size() * 2, 512));
+    old_index.swap(m_index);
+
+    for (const auto& entry : old_index)
+      if (entry.used)
+        index_insert(entry.itr);
+  }
+
+  size_t hash = hash_key(itr->first);
+  size_t mask = m_index.size() - 1;
+  size_t i    = hash & mask;
+
+  while (m_index[i].used)
+    i = (i + 1) & mask;
+
+  m_index[i] = index_entry{ hash, itr, true };
+}
+
+void
+CommandMap::index_erase(iterator itr) {
+  size_t mask = m_index.size() - 1;
+  size_t i    = hash_key(itr->first) & mask;
+
+  while (m_index[i].itr != itr)
+    i = (i + 1) & mask;
+
+  // Shift back the following entries of the probe sequence so lookups
+  // don't stop at the hole.
+  for (size_t j = (i + 1) & mask; m_index[j].used; j = (j + 1) & mask) {
+    size_t home = m_index[j].hash & mask;
+
+    if (((j - home) & mask) >= ((j - i) & mask)) {
+      m_index[i] = m_index[j];
+      i          = j;
+    }
+  }
+
+  m_index[i] = index_entry();
+}
+
+CommandMap::iterator
+CommandMap::find(const char* key) {
+  const index_entry* entry = index_find(key);
+
+  return entry != nullptr ? entry->itr : end();
+}
+
+CommandMap::const_iterator
+CommandMap::find(const char* key) const {
+  const index_entry* entry = index_find(key);
+
+  return entry != nullptr ? const_iterator(entry->itr) : end();
+}
+
 CommandMap::iterator
 CommandMap::insert(key_type key, int flags, const char* parm, const char* doc) {
-  iterator itr = base_type::find(key);
+  iterator itr = base_type::lower_bound(key);
 
-  if (itr != base_type::end())
+  if (itr != base_type::end() && std::strcmp(itr->first, key) == 0)
     throw torrent::internal_error(
       "CommandMap::insert(...) tried to insert an already existing key.");
 
@@ -52,8 +138,11 @@ CommandMap::insert(key_type key, int flags, const char* parm, const char* doc) {
     // if (rpc::rpc.is_initialized())
     rpc::rpc.insert_command(key, parm, doc);
 
-  return base_type::insert(
+  itr = base_type::insert(
     itr, value_type(key, command_map_data_type(flags, parm, doc)));
+
+  index_insert(itr);
+  return itr;
 }
 
 // void
@@ -87,14 +176,16 @@ CommandMap::erase(iterator itr) {
   const char* key =
     itr->second.m_flags & flag_delete_key ? itr->first : nullptr;
 
+  index_erase(itr);
   base_type::erase(itr);
+  m_generation++;
   delete[] key;
 }
 
 void
 CommandMap::create_redirect(key_type key_new, key_type key_dest, int flags) {
-  iterator new_itr  = base_type::find(key_new);
-  iterator dest_itr = base_type::find(key_dest);
+  iterator new_itr  = find(key_new);
+  iterator dest_itr = find(key_dest);
 
   if (dest_itr == base_type::end())
     throw torrent::input_error(
@@ -127,6 +218,8 @@ CommandMap::create_redirect(key_type key_new, key_type key_dest, int flags) {
                command_map_data_type(
                  flags, dest_itr->second.m_parm, dest_itr->second.m_doc)));
 
+  index_insert(itr);
+
   // We can assume all the slots are the same size.
   itr->second.m_variable = dest_itr->second.m_variable;
   itr->second.m_anySlot  = dest_itr->second.m_anySlot;
@@ -149,7 +242,7 @@ const CommandMap::mapped_type
 CommandMap::call_command(key_type           key,
                          const mapped_type& arg,
                          target_type        target) {
-  iterator itr = base_type::find(key);
+  iterator itr = find(key);
 
   if (itr == base_type::end())
     throw torrent::input_error("Command \"" + std::string(key) +
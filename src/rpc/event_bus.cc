@@ -0,0 +1,254 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+// Copyright (C) 2021, Contributors to the rTorrent project
+
+#include <algorithm>
+#include <cctype>
+#include <chrono>
+
+#include "globals.h"
+#include "rpc/event_bus.h"
+
+namespace rpc {
+
+EventBus::EventBus()
+  : m_ring(new event_type[ring_size]) {
+  m_taskFlush.slot() = [this] { flush(); };
+}
+
+EventBus::~EventBus() {
+  priority_queue_erase(&taskScheduler, &m_taskFlush);
+}
+
+void
+EventBus::open(defer_slot defer, publish_slot publish) {
+  m_defer   = std::move(defer);
+  m_publish = std::move(publish);
+
+  m_open.store(true, std::memory_order_release);
+}
+
+void
+EventBus::close() {
+  m_open.store(false, std::memory_order_release);
+
+  priority_queue_erase(&taskScheduler, &m_taskFlush);
+  m_overflow.clear();
+}
+
+void
+EventBus::push(const torrent::HashString& hash,
+               const char*                event,
+               uint64_t                   views) {
+  if (!is_open())
+    return;
+
+  event_type entry{ event,
+                    hash,
+                    std::chrono::duration_cast<std::chrono::milliseconds>(
+                      std::chrono::system_clock::now().time_since_epoch())
+                      .count(),
+                    views };
+
+  // Keep the order by not going around the events that didn't fit.
+  if (!m_overflow.empty() || !push_ring(entry))
+    m_overflow.push_back(entry);
+
+  if (!m_taskFlush.is_queued())
+    priority_queue_insert(
+      &taskScheduler,
+      &m_taskFlush,
+      cachedTime + torrent::utils::timer::from_milliseconds(m_flushInterval));
+}
+
+void
+EventBus::flush() {
+  if (!is_open())
+    return;
+
+  auto itr = m_overflow.begin();
+
+  while (itr != m_overflow.end() && push_ring(*itr))
+    ++itr;
+
+  m_overflow.erase(m_overflow.begin(), itr);
+
+  if (m_ringHead.load(std::memory_order_relaxed) !=
+        m_ringTail.load(std::memory_order_acquire) &&
+      !m_draining.exchange(true))
+    m_defer([this, views = m_views] { drain(*views); });
+
+  // Retry after another interval, giving the loop time to make room
+  // instead of rescheduling for the current time.
+  if (!m_overflow.empty() && !m_taskFlush.is_queued())
+    priority_queue_insert(&taskScheduler,
+                          &m_taskFlush,
+                          cachedTime + torrent::utils::timer::from_milliseconds(
+                                         std::max<uint32_t>(m_flushInterval, 1)));
+}
+
+size_t
+EventBus::pending() const {
+  return m_ringHead.load(std::memory_order_relaxed) -
+         m_ringTail.load(std::memory_order_acquire) + m_overflow.size();
+}
+
+bool
+EventBus::push_ring(const event_type& event) {
+  uint32_t head = m_ringHead.load(std::memory_order_relaxed);
+
+  if (head - m_ringTail.load(std::memory_order_acquire) == ring_size)
+    return false;
+
+  m_ring[head % ring_size] = event;
+  m_ringHead.store(head + 1, std::memory_order_release);
+  return true;
+}
+
+std::string
+EventBus::normalize_topic(const std::string& topic) {
+  if (topic == "event.*")
+    return topic;
+
+  auto has_prefix = [&topic](const char* prefix, size_t length) {
+    return topic.size() > length && topic.compare(0, length, prefix) == 0;
+  };
+
+  // Event names are only letters and underscores, so they need no
+  // escaping when serialized.
+  if (has_prefix("event.download.", 15)) {
+    if (std::all_of(topic.begin() + 15, topic.end(), [](char c) {
+          return std::islower((unsigned char)c) || c == '_';
+        }))
+      return topic;
+
+    return std::string();
+  }
+
+  if (has_prefix("hash.", 5)) {
+    if (topic.size() != 5 + 2 * torrent::HashString::size_data ||
+        !std::all_of(topic.begin() + 5, topic.end(), [](char c) {
+          return std::isxdigit((unsigned char)c);
+        }))
+      return std::string();
+
+    std::string result = topic;
+    std::transform(
+      result.begin() + 5, result.end(), result.begin() + 5, [](char c) {
+        return std::toupper((unsigned char)c);
+      });
+
+    return result;
+  }
+
+  if (has_prefix("view.", 5))
+    return topic;
+
+  return std::string();
+}
+
+void
+EventBus::subscribe(const std::string& topic) {
+  if (m_subscribers[topic]++ != 0)
+    return;
+
+  if (topic.compare(0, 5, "hash.") == 0)
+    m_hashSubscribers++;
+  else if (topic.compare(0, 5, "view.") == 0)
+    m_viewSubscribers++;
+}
+
+void
+EventBus::unsubscribe(const std::string& topic) {
+  auto itr = m_subscribers.find(topic);
+
+  if (itr == m_subscribers.end() || --itr->second != 0)
+    return;
+
+  m_subscribers.erase(itr);
+  m_buffers.erase(topic);
+
+  if (topic.compare(0, 5, "hash.") == 0)
+    m_hashSubscribers--;
+  else if (topic.compare(0, 5, "view.") == 0)
+    m_viewSubscribers--;
+}
+
+// Appends the serialized event in 'm_event' to the topic's frame.
+void
+EventBus::append(const std::string& topic) {
+  if (m_subscribers.find(topic) == m_subscribers.end())
+    return;
+
+  std::string& buffer = m_buffers[topic];
+
+  buffer.append(buffer.empty() ? "{\"jsonrpc\":\"2.0\",\"result\":[" : ",");
+  buffer.append(m_event);
+}
+
+void
+EventBus::drain(const view_list& views) {
+  static const char hex[] = "0123456789ABCDEF";
+
+  // Cleared first so events pushed from now on get another drain.
+  m_draining.store(false);
+
+  uint32_t tail = m_ringTail.load(std::memory_order_relaxed);
+  uint32_t head = m_ringHead.load(std::memory_order_acquire);
+
+  for (; tail != head; tail++) {
+    const event_type& entry = m_ring[tail % ring_size];
+
+    if (m_subscribers.empty())
+      continue;
+
+    m_event.assign("{\"target\":\"");
+
+    for (unsigned char c : entry.hash) {
+      m_event.push_back(hex[c >> 4]);
+      m_event.push_back(hex[c & 0xf]);
+    }
+
+    m_event.append("\",\"event\":\"");
+    m_event.append(entry.event);
+    m_event.append("\",\"timestamp\":");
+    m_event.append(std::to_string(entry.timestamp));
+    m_event.push_back('}');
+
+    m_topic.assign("event.*");
+    append(m_topic);
+
+    m_topic.assign(entry.event);
+    append(m_topic);
+
+    if (m_hashSubscribers != 0) {
+      m_topic.assign("hash.");
+      m_topic.append(m_event, 11, 2 * torrent::HashString::size_data);
+      append(m_topic);
+    }
+
+    for (size_t i = 0; i < views.size() && i < max_views; i++) {
+      if (!(entry.views & (uint64_t(1) << i)))
+        continue;
+
+      m_topic.assign("view.");
+      m_topic.append(views[i]);
+      append(m_topic);
+    }
+  }
+
+  m_ringTail.store(tail, std::memory_order_release);
+
+  for (auto& buffer : m_buffers) {
+    if (buffer.second.empty())
+      continue;
+
+    buffer.second.append("]}");
+
+    if (is_open())
+      m_publish(buffer.first, buffer.second);
+
+    buffer.second.clear();
+  }
+}
+
+}
@@ -101,16 +101,19 @@ parse_command_name(const char* first,
   return first;
 }
 
-// Set 'download' to NULL to call the generic functions, thus reusing
-// the code below for both cases.
-parse_command_type
-parse_command(target_type target, const char* first, const char* last) {
+// Splits a command into its name and arguments without calling
+// it. An empty 'key' indicates there was no command to parse.
+static const char*
+parse_command_split(const char*      first,
+                    const char*      last,
+                    char*            key,
+                    torrent::Object* args) {
   first = std::find_if(first, last, std::not_fn(command_map_is_space()));
 
-  if (first == last || *first == '#')
-    return std::make_pair(torrent::Object(), first);
-
-  char key[128];
+  if (first == last || *first == '#') {
+    *key = '\0';
+    return first;
+  }
 
   first = parse_command_name(first, last, key, key + 128);
   first = std::find_if(first, last, std::not_fn(command_map_is_space()));
@@ -119,8 +122,7 @@ parse_command(target_type target, const char* first, const char* last) {
     throw torrent::input_error("Could not find '=' in command '" +
                                std::string(key) + "'.");
 
-  torrent::Object args;
-  first = parse_whole_list(first + 1, last, &args, &parse_is_delim_command);
+  first = parse_whole_list(first + 1, last, args, &parse_is_delim_command);
 
   // Find the last character that is part of this command, skipping
   // the whitespace at the end. This ensures us that the caller
@@ -134,6 +136,21 @@ parse_command(target_type target, const char* first, const char* last) {
     first++;
   }
 
+  return first;
+}
+
+// Set 'download' to NULL to call the generic functions, thus reusing
+// the code below for both cases.
+parse_command_type
+parse_command(target_type target, const char* first, const char* last) {
+  char            key[128];
+  torrent::Object args;
+
+  first = parse_command_split(first, last, key, &args);
+
+  if (*key == '\0')
+    return std::make_pair(torrent::Object(), first);
+
   // Replace any strings starting with '$' with the result of the
   // following command.
   parse_command_execute(target, &args);
@@ -141,6 +158,58 @@ parse_command(target_type target, const char* first, const char* last) {
   return std::make_pair(commands.call_command(key, args, target), first);
 }
 
+// Mirrors the objects 'parse_command_execute' would modify.
+static bool
+parse_command_needs_execute(const torrent::Object& object) {
+  if (object.is_list())
+    return std::any_of(object.as_list().begin(),
+                       object.as_list().end(),
+                       [](const torrent::Object& o) {
+                         return !o.is_list() && parse_command_needs_execute(o);
+                       });
+
+  if (object.is_dict_key())
+    return true;
+
+  return object.is_string() && *object.as_string().c_str() == '$';
+}
+
+parsed_command
+parse_command_compile(const char* first, const char* last) {
+  char           key[128];
+  parsed_command result;
+
+  parse_command_split(first, last, key, &result.args);
+
+  if (*key == '\0') {
+    result.itr = commands.end();
+    return result;
+  }
+
+  result.itr = commands.find(key);
+
+  if (result.itr == commands.end())
+    throw torrent::input_error("Command \"" + std::string(key) +
+                               "\" does not exist.");
+
+  result.execute = parse_command_needs_execute(result.args);
+  return result;
+}
+
+torrent::Object
+call_parsed_command(const parsed_command& cmd, target_type target) {
+  if (cmd.itr == commands.end())
+    return torrent::Object();
+
+  if (!cmd.execute)
+    return commands.call_command(cmd.itr, cmd.args, target);
+
+  torrent::Object args = cmd.args;
+  parse_command_execute(target, &args);
+
+  return commands.call_command(cmd.itr, args, target);
+}
+
 torrent::Object
 parse_command_multiple(target_type target,
                        const char* first,
@@ -6,8 +6,11 @@
 #ifdef HAVE_JSON
 
 #include <algorithm>
+#include <cinttypes>
 #include <cstddef>
 #include <cstdint>
+#include <cstdio>
+#include <functional>
 #include <iterator>
 #include <string>
 #include <string_view>
@@ -22,6 +25,7 @@
 #include "rpc/command.h"
 #include "rpc/command_map.h"
 #include "rpc/parse_commands.h"
+#include "rpc/rpc_worker_pool.h"
 #include "thread_base.h"
 #include "utils/jsonrpc/common.h"
 
@@ -164,57 +168,219 @@ json_to_object(const json& value, int callType, rpc::target_type* target) {
   }
 }
 
-json
-object_to_json(const torrent::Object& object) noexcept {
+// Appends 'str' as a quoted JSON string, escaped the same way as
+// 'json::dump' with 'error_handler_t::replace': invalid UTF-8
+// sequences are replaced with U+FFFD.
+void
+json_write_string(const std::string& str, std::string* dest) {
+  static constexpr char hex[]         = "0123456789abcdef";
+  static constexpr char replacement[] = "\xEF\xBF\xBD";
+
+  dest->push_back('"');
+
+  const auto* first = reinterpret_cast<const unsigned char*>(str.data());
+  const auto* last  = first + str.size();
+
+  while (first != last) {
+    unsigned char c = *first;
+
+    if (c >= 0x80) {
+      // Length and range of the second byte, see RFC 3629.
+      int           length = 0;
+      unsigned char lower  = 0x80;
+      unsigned char upper  = 0xBF;
+
+      if (c >= 0xC2 && c <= 0xDF) {
+        length = 2;
+      } else if (c >= 0xE0 && c <= 0xEF) {
+        length = 3;
+        lower  = c == 0xE0 ? 0xA0 : 0x80;
+        upper  = c == 0xED ? 0x9F : 0xBF;
+      } else if (c >= 0xF0 && c <= 0xF4) {
+        length = 4;
+        lower  = c == 0xF0 ? 0x90 : 0x80;
+        upper  = c == 0xF4 ? 0x8F : 0xBF;
+      }
+
+      int valid = length != 0 ? 1 : 0;
+
+      while (valid != 0 && valid < length && first + valid != last &&
+             first[valid] >= (valid == 1 ? lower : 0x80) &&
+             first[valid] <= (valid == 1 ? upper : 0xBF))
+        valid++;
+
+      if (valid != 0 && valid == length) {
+        dest->append(reinterpret_cast<const char*>(first), length);
+        first += length;
+      } else {
+        // Replace the maximal invalid subpart, continuing with the
+        // byte that broke the sequence.
+        dest->append(replacement, 3);
+        first += valid != 0 ? valid : 1;
+      }
+
+      continue;
+    }
+
+    switch (c) {
+      case '"':
+        dest->append("\\\"", 2);
+        break;
+      case '\\':
+        dest->append("\\\\", 2);
+        break;
+      case '\b':
+        dest->append("\\b", 2);
+        break;
+      case '\f':
+        dest->append("\\f", 2);
+        break;
+      case '\n':
+        dest->append("\\n", 2);
+        break;
+      case '\r':
+        dest->append("\\r", 2);
+        break;
+      case '\t':
+        dest->append("\\t", 2);
+        break;
+      default:
+        if (c < 0x20) {
+          const char escaped[] = {
+            '\\', 'u', '0', '0', hex[c >> 4], hex[c & 0xf]
+          };
+          dest->append(escaped, sizeof(escaped));
+        } else {
+          dest->push_back(c);
+        }
+    }
+
+    first++;
+  }
+
+  dest->push_back('"');
+}
+
+// Serializes 'object' directly as JSON text, producing the same
+// output as dumping the equivalent 'json' tree.
+void
+json_write_object(const torrent::Object& object, std::string* dest) {
   switch (object.type()) {
-    case torrent::Object::TYPE_VALUE:
-      return object.as_value();
+    case torrent::Object::TYPE_VALUE: {
+      char buffer[24];
+      int  length = snprintf(
+        buffer, sizeof(buffer), "%" PRId64, (int64_t)object.as_value());
+
+      dest->append(buffer, length);
+      break;
+    }
     case torrent::Object::TYPE_STRING:
-      return object.as_string();
+      json_write_string(object.as_string(), dest);
+      break;
     case torrent::Object::TYPE_LIST: {
-      json result = json::array();
-      std::transform(
-        object.as_list().cbegin(),
-        object.as_list().cend(),
-        std::back_inserter(result),
-        [](const torrent::Object& element) { return object_to_json(element); });
-      return result;
+      dest->push_back('[');
+
+      for (auto itr = object.as_list().begin(), last = object.as_list().end();
+           itr != last;
+           itr++) {
+        if (itr != object.as_list().begin())
+          dest->push_back(',');
+
+        json_write_object(*itr, dest);
+      }
+
+      dest->push_back(']');
+      break;
     }
     case torrent::Object::TYPE_MAP: {
-      json result = json::object();
+      dest->push_back('{');
 
-      for (const auto& [k, v] : object.as_map()) {
-        result.emplace(k, object_to_json(v));
+      for (auto itr = object.as_map().begin(), last = object.as_map().end();
+           itr != last;
+           itr++) {
+        if (itr != object.as_map().begin())
+          dest->push_back(',');
+
+        json_write_string(itr->first, dest);
+        dest->push_back(':');
+        json_write_object(itr->second, dest);
       }
 
-      return result;
+      dest->push_back('}');
+      break;
     }
     case torrent::Object::TYPE_DICT_KEY: {
-      json result = json::array();
-
-      result.push_back(object_to_json(object.as_dict_key()));
+      dest->push_back('[');
+      json_write_string(object.as_dict_key(), dest);
 
       const auto& dict_obj = object.as_dict_obj();
+
       if (dict_obj.is_list()) {
-        std::transform(dict_obj.as_list().cbegin(),
-                       dict_obj.as_list().cend(),
-                       std::back_inserter(result),
-                       [](const torrent::Object& element) {
-                         return object_to_json(element);
-                       });
+        for (const auto& element : dict_obj.as_list()) {
+          dest->push_back(',');
+          json_write_object(element, dest);
+        }
       } else {
-        result.push_back(object_to_json(dict_obj));
+        dest->push_back(',');
+        json_write_object(dict_obj, dest);
       }
 
-      return result;
+      dest->push_back(']');
+      break;
     }
     default:
-      return 0;
+      dest->push_back('0');
+  }
+}
+
+// Set while the current thread holds the global lock on behalf of a
+// whole batch, so the individual calls don't lock again.
+static thread_local bool jsonrpc_batch_locked = false;
+
+static bool
+jsonrpc_is_readonly(const json& request) {
+  // Malformed requests are rejected without calling anything.
+  if (!request.is_object())
+    return true;
+
+  const auto& method = request.find("method");
+
+  if (method == request.end() || !method->is_string())
+    return true;
+
+  const auto& name = method->get_ref<const std::string&>();
+
+  return name == "system.listMethods" || readonly_command.count(name) != 0;
+}
+
+void
+jsonrpc_call_batch(const json& requests, const std::function<void()>& process) {
+  std::shared_lock<std::shared_mutex> read_lock;
+  std::unique_lock<std::shared_mutex> write_lock;
+
+  if (std::all_of(requests.begin(), requests.end(), &jsonrpc_is_readonly)) {
+    read_lock = std::shared_lock(torrent::thread_base::m_global.lock);
+  } else {
+    write_lock = std::unique_lock(torrent::thread_base::m_global.lock);
+    torrent::main_thread()->interrupt();
+  }
+
+  jsonrpc_batch_locked = true;
+
+  try {
+    process();
+  } catch (...) {
+    jsonrpc_batch_locked = false;
+    throw;
   }
+
+  jsonrpc_batch_locked = false;
 }
 
-json
-jsonrpc_call_command(const std::string& method, const json& params) {
+void
+jsonrpc_call_command(const std::string& method,
+                     const json&        params,
+                     std::string&       result) {
   if (params.type() != json::value_t::array) {
     if (params.type() == json::value_t::object) {
       throw JsonRpcException(
@@ -226,11 +392,17 @@ jsonrpc_call_command(const std::string& method, const json& params) {
   }
 
   if (std::string_view("system.listMethods") == method) {
-    json methods = json::array();
+    bool first = true;
+    result.push_back('[');
     for (const auto& [k, v] : commands) {
-      methods.push_back(k);
+      if (!first) {
+        result.push_back(',');
+      }
+      json_write_string(k, &result);
+      first = false;
     }
-    return methods;
+    result.push_back(']');
+    return;
   }
 
   CommandMap::iterator itr = commands.find(method.c_str());
@@ -246,10 +418,11 @@ jsonrpc_call_command(const std::string& method, const json& params) {
     std::shared_lock<std::shared_mutex> read_lock;
     std::unique_lock<std::shared_mutex> write_lock;
 
-    if (readonly_command.count(method)) {
+    if (jsonrpc_batch_locked) {
+      // The lock is already held for the whole batch.
+    } else if (readonly_command.count(method)) {
       read_lock = std::shared_lock(torrent::thread_base::m_global.lock);
-    }
-    else {
+    } else {
       write_lock = std::unique_lock(torrent::thread_base::m_global.lock);
       torrent::main_thread()->interrupt();
     }
@@ -266,9 +439,7 @@ jsonrpc_call_command(const std::string& method, const json& params) {
       json_to_object(params, command_base::target_any, &target).swap(object);
     }
 
-    const auto& result = rpc::commands.call_command(itr, object, target);
-
-    return object_to_json(result);
+    json_write_object(rpc::commands.call_command(itr, object, target), &result);
   } catch (torrent::input_error& e) {
     throw JsonRpcException(-32602, e.what());
   } catch (torrent::local_error& e) {
@@ -278,7 +449,8 @@ jsonrpc_call_command(const std::string& method, const json& params) {
 
 void
 RpcJson::initialize() {
-  m_jsonrpc = new jsonrpccxx::JsonRpc2Server(&jsonrpc_call_command);
+  m_jsonrpc = new jsonrpccxx::JsonRpc2Server(&jsonrpc_call_command,
+                                             &jsonrpc_call_batch);
 }
 
 void
@@ -293,8 +465,42 @@ RpcJson::is_valid() const {
 
 bool
 RpcJson::process(const char* inBuffer, uint32_t length, res_callback callback) {
-  const std::string& response = m_jsonrpc->HandleRequest(std::string_view(inBuffer, length));
-  return callback(response.c_str(), response.size());
+  // Responses are written into a per-thread buffer that keeps its
+  // capacity between requests, unless it grew unusually large.
+  static thread_local std::string response;
+
+  m_jsonrpc->HandleRequest(std::string_view(inBuffer, length), response);
+
+  bool result = callback(response.c_str(), response.size());
+
+  if (response.capacity() > max_retained_buffer) {
+    std::string().swap(response);
+  }
+
+  return result;
+}
+
+bool
+RpcJson::process_readonly(const char*    inBuffer,
+                          uint32_t       length,
+                          RpcWorkerPool& pool,
+                          async_callback callback) {
+  json request = json::parse(std::string_view(inBuffer, length), nullptr, false);
+
+  // Errors and requests with side effects are left to 'process'.
+  if (request.is_discarded() ||
+      (request.is_array()
+         ? !std::all_of(request.begin(), request.end(), &jsonrpc_is_readonly)
+         : !request.is_object() || !jsonrpc_is_readonly(request)))
+    return false;
+
+  pool.push([this, request = std::move(request), callback]() mutable {
+    std::string response;
+    m_jsonrpc->HandleParsedRequest(request, response);
+    callback(std::move(response));
+  });
+
+  return true;
 }
 
 }
@@ -6,6 +6,8 @@
 
 #include <torrent/exceptions.h>
 
+#include "thread_base.h"
+
 #include "rpc/rpc_json.h"
 #include "rpc/rpc_xml.h"
 
@@ -56,6 +58,25 @@ RpcManager::dispatch(RPCType            type,
   }
 }
 
+bool
+RpcManager::dispatch_readonly(RPCType              type,
+                              const char*          inBuffer,
+                              uint32_t             length,
+                              IRpc::async_callback callback) {
+#ifdef HAVE_JSON
+  // XML-RPC requests are only identified once parsed and executed by
+  // xmlrpc-c, so they always run on the I/O thread.
+  if (m_workers.size() == 0 || type != RPCType::JSON ||
+      !m_rpcProcessors[RPCType::JSON]->is_valid())
+    return false;
+
+  return static_cast<RpcJson*>(m_rpcProcessors[RPCType::JSON])
+    ->process_readonly(inBuffer, length, m_workers, std::move(callback));
+#else
+  return false;
+#endif
+}
+
 void
 RpcManager::initialize(slot_download fun_d,
                        slot_file     fun_f,
@@ -74,6 +95,12 @@ RpcManager::initialize(slot_download fun_d,
 
 void
 RpcManager::cleanup() {
+  // Running jobs may be waiting for the global lock held by the main
+  // thread.
+  ThreadBase::release_global_lock();
+  m_workers.stop();
+  ThreadBase::acquire_global_lock();
+
   m_rpcProcessors[RPCType::XML]->cleanup();
   m_rpcProcessors[RPCType::JSON]->cleanup();
 }
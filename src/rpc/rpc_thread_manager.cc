@@ -48,6 +48,18 @@ torrent::Poll* RpcThreadManager::poll() {
   return m_thread_worker->poll();
 }
 
+ThreadBase::priority_queue* RpcThreadManager::task_scheduler() {
+  return &m_thread_worker->task_scheduler();
+}
+
+rpc::SCgiSender* RpcThreadManager::scgi_sender() {
+  return m_thread_worker->scgi_sender();
+}
+
 void RpcThreadManager::publish_ws_topic(std::string_view topic, std::string_view message) {
   m_websockets_thread->publish_ws_topic(topic, message);
+}
+
+rpc::EventBus* RpcThreadManager::event_bus() {
+  return m_websockets_thread->event_bus();
 }
\ No newline at end of file
@@ -0,0 +1,123 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+// Copyright (C) 2021, Contributors to the rTorrent project
+
+#include <algorithm>
+#include <csignal>
+#include <iterator>
+#include <pthread.h>
+
+#include <torrent/exceptions.h>
+
+#include "rpc/rpc_worker_pool.h"
+
+namespace rpc {
+
+RpcWorkerPool::~RpcWorkerPool() {
+  stop();
+}
+
+size_t
+RpcWorkerPool::thread_count() {
+  std::lock_guard<std::mutex> guard(m_lock);
+  return m_threads.size();
+}
+
+void
+RpcWorkerPool::resize(unsigned int count) {
+  if (count > max_size)
+    throw torrent::input_error("Too many RPC worker threads.");
+
+  std::vector<std::thread> exited;
+
+  {
+    std::lock_guard<std::mutex> guard(m_lock);
+
+    auto itr = std::partition(
+      m_threads.begin(), m_threads.end(), [this](const std::thread& thread) {
+        return std::find(m_exited.begin(), m_exited.end(), thread.get_id()) ==
+               m_exited.end();
+      });
+
+    std::move(itr, m_threads.end(), std::back_inserter(exited));
+    m_threads.erase(itr, m_threads.end());
+    m_exited.clear();
+
+    m_size = count;
+
+    while (m_running < count) {
+      m_threads.emplace_back(&RpcWorkerPool::run, this);
+      m_running++;
+    }
+  }
+
+  m_condition.notify_all();
+
+  // These have already returned from run(), so joining doesn't wait on
+  // jobs.
+  for (auto& thread : exited)
+    thread.join();
+}
+
+void
+RpcWorkerPool::stop() {
+  std::vector<std::thread> threads;
+  std::deque<job_type>     jobs;
+
+  {
+    std::lock_guard<std::mutex> guard(m_lock);
+    m_size = 0;
+    threads.swap(m_threads);
+    jobs.swap(m_jobs);
+    m_exited.clear();
+  }
+
+  m_condition.notify_all();
+
+  for (auto& thread : threads)
+    thread.join();
+}
+
+void
+RpcWorkerPool::push(job_type job) {
+  {
+    std::lock_guard<std::mutex> guard(m_lock);
+
+    if (m_size != 0) {
+      m_jobs.push_back(std::move(job));
+      m_condition.notify_one();
+      return;
+    }
+  }
+
+  job();
+}
+
+void
+RpcWorkerPool::run() {
+  // Leave signal handling to the main thread.
+  sigset_t signals;
+  sigfillset(&signals);
+  pthread_sigmask(SIG_BLOCK, &signals, nullptr);
+
+  std::unique_lock<std::mutex> lock(m_lock);
+
+  while (true) {
+    m_condition.wait(lock,
+                     [this] { return !m_jobs.empty() || m_running > m_size; });
+
+    if (m_jobs.empty()) {
+      m_running--;
+      m_exited.push_back(std::this_thread::get_id());
+      return;
+    }
+
+    job_type job = std::move(m_jobs.front());
+    m_jobs.pop_front();
+
+    lock.unlock();
+    job();
+    lock.lock();
+  }
+}
+
+}
@@ -1,7 +1,10 @@
 // SPDX-License-Identifier: GPL-2.0-or-later
 // Copyright (C) 2005-2011, Jari Sundell <jaris@ifi.uio.no>
 
+#include <algorithm>
+#include <cerrno>
 #include <sys/stat.h>
+#include <sys/uio.h>
 #include <sys/un.h>
 
 #include <torrent/connection_manager.h>
@@ -14,12 +17,20 @@
 #include "control.h"
 #include "globals.h"
 #include "rpc/parse_commands.h"
+#include "thread_worker.h"
 #include "utils/socket_fd.h"
 
 #include "rpc/scgi.h"
 
 namespace rpc {
 
+SCgi::SCgi() {
+  m_freeTasks.reserve(max_tasks);
+
+  for (SCgiTask* itr = m_task + max_tasks; itr != m_task;)
+    m_freeTasks.push_back(--itr);
+}
+
 SCgi::~SCgi() {
   if (!get_fd().is_valid())
     return;
@@ -122,17 +133,17 @@ SCgi::event_read() {
   utils::SocketFd                fd;
 
   while ((fd = get_fd().accept(&sa)).is_valid()) {
-    SCgiTask* task =
-      std::find_if(m_task, m_task + max_tasks, [](SCgiTask& task) {
-        return task.is_available();
-      });
-
-    if (task == m_task + max_tasks) {
-      // Ergh... just closing for now.
+    if (m_freeTasks.empty()) {
+      // All tasks are busy, count it so the client's retries can be
+      // diagnosed.
+      m_rejected++;
       fd.close();
       continue;
     }
 
+    SCgiTask* task = m_freeTasks.back();
+    m_freeTasks.pop_back();
+
     task->open(this, fd.get_fd());
   }
 }
@@ -147,8 +158,23 @@ SCgi::event_error() {
   throw torrent::internal_error("SCGI listener port received an error event.");
 }
 
+void
+SCgi::release_task(SCgiTask* task) {
+  m_freeTasks.push_back(task);
+}
+
 bool
 SCgi::receive_call(SCgiTask* task, const char* buffer, uint32_t length) {
+  if (task->type() == SCgiTask::ContentType::JSON &&
+      rpc.dispatch_readonly(
+        RpcManager::RPCType::JSON,
+        buffer,
+        length,
+        [this, task, generation = task->generation()](std::string&& response) {
+          queue_response(task, generation, std::move(response));
+        }))
+    return true;
+
   bool       result   = false;
   const auto callback = [task](const char* buffer, uint32_t length) {
     return task->receive_write(buffer, length);
@@ -167,41 +193,120 @@ SCgi::receive_call(SCgiTask* task, const char* buffer, uint32_t length) {
   return result;
 }
 
+void
+SCgi::queue_response(SCgiTask*     task,
+                     uint32_t      generation,
+                     std::string&& response) {
+  std::lock_guard<std::mutex> guard(m_responseLock);
+
+  m_responses.push_back({ task, generation, std::move(response) });
+
+  // Only wake the thread for the first response, the rest are picked
+  // up by the same call.
+  if (m_responses.size() == 1)
+    worker_thread->queue_item((void*)&ThreadWorker::msg_deliver_responses);
+}
+
+void
+SCgi::deliver_responses() {
+  std::vector<queued_response> responses;
+
+  {
+    std::lock_guard<std::mutex> guard(m_responseLock);
+    responses.swap(m_responses);
+  }
+
+  for (auto& itr : responses) {
+    // The client may have disconnected while the call was executed.
+    if (!itr.task->is_open() || itr.task->generation() != itr.generation)
+      continue;
+
+    itr.task->receive_write(itr.response.c_str(), itr.response.size());
+  }
+}
+
+// Writes as much of the iovec as the non-blocking socket takes,
+// advancing it past the written data. Returns false on errors.
+static bool
+scgi_write(int fd, struct iovec*& iov, int& iovcnt) {
+  while (iovcnt != 0) {
+    ssize_t bytes = ::writev(fd, iov, iovcnt);
+
+    if (bytes == -1) {
+      if (errno == EINTR)
+        continue;
+
+      return torrent::utils::error_number::current().is_blocked_momentary();
+    }
+
+    while (iovcnt != 0 && (size_t)bytes >= iov->iov_len) {
+      bytes -= iov->iov_len;
+      iov++;
+      iovcnt--;
+    }
+
+    if (iovcnt != 0) {
+      iov->iov_base = static_cast<char*>(iov->iov_base) + bytes;
+      iov->iov_len -= bytes;
+    }
+  }
+
+  return true;
+}
+
 bool
 SCgi::process_and_send(int fd, const char* data, int length, bool is_json) {
+  // Skip the SCGI headers, the body follows the netstring's ','.
+  const char* last = data + length;
+  const char* body = std::find(data, last, ',');
+
+  if (body == last)
+    return false;
+
+  ++body;
 
-  static auto callback = [&](const char* buffer, uint32_t length) {
-      const auto header = is_json
+  const auto callback = [fd, is_json](const char* buffer, uint32_t length) {
+    const auto header = is_json
                           ? "Status: 200 OK\r\nContent-Type: "
-                            "application/json\r\nContent-Length: %i\r\n\r\n"
+                            "application/json\r\nContent-Length: %u\r\n\r\n"
                           : "Status: 200 OK\r\nContent-Type: "
-                            "text/xml\r\nContent-Length: %i\r\n\r\n";
+                            "text/xml\r\nContent-Length: %u\r\n\r\n";
 
-      char* data_buffer = new char[length + 256];
-      int header_size = sprintf(data_buffer, header, length);
+    // The response is sent straight from the RPC buffer, so only the
+    // header needs to be formatted.
+    char header_buffer[128];
+    int  header_size =
+      snprintf(header_buffer, sizeof(header_buffer), header, length);
 
-      std::memcpy(data_buffer + header_size, buffer, length);
-      ::send(fd, data_buffer, header_size + length, 0);
+    struct iovec iov[2] = {
+      { header_buffer, (size_t)header_size },
+      { const_cast<char*>(buffer), length },
+    };
+
+    SCgiSender* sender =
+      worker_thread != nullptr ? worker_thread->scgi_sender() : nullptr;
+
+    // Queue behind the unsent part of earlier responses.
+    if (sender != nullptr && sender->append(fd, iov, 2))
       return true;
-  };
 
-  bool result = true;
-  int head_length = 0;
+    struct iovec* itr    = iov;
+    int           iovcnt = 2;
 
-  while (*data != ','){
-    ++data; ++head_length;
-  }
-  ++data; ++head_length;
-  length -= head_length;
+    if (!scgi_write(fd, itr, iovcnt))
+      return false;
 
-  if (is_json) {
-    result = rpc.dispatch(RpcManager::RPCType::JSON, data, length, callback);
-  }
-  else {
-    result = rpc.dispatch(RpcManager::RPCType::XML, data, length, callback);
-  }
+    // The client isn't reading as fast as we send, so let the worker
+    // thread finish rather than stall the loop.
+    return iovcnt == 0 || (sender != nullptr && sender->queue(fd, itr, iovcnt));
+  };
 
-  return result;
+  if (is_json)
+    return rpc.dispatch(
+      RpcManager::RPCType::JSON, body, std::distance(body, last), callback);
+  else
+    return rpc.dispatch(
+      RpcManager::RPCType::XML, body, std::distance(body, last), callback);
 }
 
 } // namespace rpc
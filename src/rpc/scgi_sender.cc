@@ -0,0 +1,243 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+// Copyright (C) 2021, Contributors to the rTorrent project
+
+#include <algorithm>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <torrent/event.h>
+#include <torrent/poll.h>
+#include <torrent/utils/error_number.h>
+
+#include "globals.h"
+#include "thread_worker.h"
+
+#include "rpc/scgi_sender.h"
+
+namespace rpc {
+
+class SCgiSender::Connection : public torrent::Event {
+public:
+  Connection(SCgiSender* parent, int fd, ino_t inode)
+    : m_parent(parent)
+    , m_inode(inode) {
+    m_fileDesc = fd;
+  }
+
+  const char* type_name() const override {
+    return "scgi-sender";
+  }
+
+  ino_t inode() const {
+    return m_inode;
+  }
+  bool is_polled() const {
+    return m_polled;
+  }
+  void set_polled() {
+    m_polled       = true;
+    m_lastProgress = cachedTime;
+  }
+
+  const torrent::utils::timer& last_progress() const {
+    return m_lastProgress;
+  }
+
+  void append(const struct iovec* iov, int iovcnt);
+
+  void event_read() override {}
+  void event_write() override;
+  void event_error() override;
+
+private:
+  SCgiSender* m_parent;
+  ino_t       m_inode;
+  bool        m_polled{ false };
+
+  std::string m_buffer;
+  size_t      m_position{ 0 };
+
+  torrent::utils::timer m_lastProgress;
+};
+
+static bool
+socket_inode(int fd, ino_t* inode) {
+  struct stat st;
+
+  if (::fstat(fd, &st) == -1)
+    return false;
+
+  *inode = st.st_ino;
+  return true;
+}
+
+void
+SCgiSender::Connection::append(const struct iovec* iov, int iovcnt) {
+  // Drop what has been sent before growing the buffer.
+  if (m_position != 0) {
+    m_buffer.erase(0, m_position);
+    m_position = 0;
+  }
+
+  for (; iovcnt != 0; iov++, iovcnt--)
+    m_buffer.append(static_cast<const char*>(iov->iov_base), iov->iov_len);
+}
+
+void
+SCgiSender::Connection::event_write() {
+  std::lock_guard<std::mutex> guard(m_parent->m_lock);
+
+  ssize_t bytes = ::send(
+    m_fileDesc, m_buffer.data() + m_position, m_buffer.size() - m_position, 0);
+
+  if (bytes == -1) {
+    if (!torrent::utils::error_number::current().is_blocked_momentary())
+      m_parent->close_connection(this, true);
+
+    return;
+  }
+
+  m_position += bytes;
+  m_lastProgress = cachedTime;
+
+  if (m_position == m_buffer.size())
+    m_parent->close_connection(this, false);
+}
+
+void
+SCgiSender::Connection::event_error() {
+  std::lock_guard<std::mutex> guard(m_parent->m_lock);
+
+  m_parent->close_connection(this, true);
+}
+
+SCgiSender::SCgiSender(ThreadBase* thread)
+  : m_thread(thread) {
+  m_taskTimeout.slot() = [this] { receive_timeout(); };
+}
+
+SCgiSender::~SCgiSender() {
+  priority_queue_erase(&m_thread->task_scheduler(), &m_taskTimeout);
+
+  while (!m_connections.empty())
+    close_connection(m_connections.back(), false);
+}
+
+bool
+SCgiSender::append(int fd, const struct iovec* iov, int iovcnt) {
+  if (size() == 0)
+    return false;
+
+  ino_t inode;
+
+  if (!socket_inode(fd, &inode))
+    return false;
+
+  std::lock_guard<std::mutex> guard(m_lock);
+
+  auto itr = std::find_if(
+    m_connections.begin(), m_connections.end(), [inode](Connection* c) {
+      return c->inode() == inode;
+    });
+
+  if (itr == m_connections.end())
+    return false;
+
+  (*itr)->append(iov, iovcnt);
+  return true;
+}
+
+bool
+SCgiSender::queue(int fd, const struct iovec* iov, int iovcnt) {
+  ino_t inode;
+
+  if (!socket_inode(fd, &inode))
+    return false;
+
+  int duplicate = ::dup(fd);
+
+  if (duplicate == -1)
+    return false;
+
+  Connection* connection = new Connection(this, duplicate, inode);
+  connection->append(iov, iovcnt);
+
+  {
+    std::lock_guard<std::mutex> guard(m_lock);
+
+    m_connections.push_back(connection);
+    m_size.store(m_connections.size(), std::memory_order_relaxed);
+  }
+
+  // The poll may only be changed by its own thread.
+  m_thread->queue_item(&ThreadWorker::msg_open_scgi_sender);
+  return true;
+}
+
+void
+SCgiSender::open_connections() {
+  std::lock_guard<std::mutex> guard(m_lock);
+
+  for (Connection* connection : m_connections) {
+    if (connection->is_polled())
+      continue;
+
+    m_thread->poll()->open(connection);
+    m_thread->poll()->insert_write(connection);
+    m_thread->poll()->insert_error(connection);
+    connection->set_polled();
+  }
+
+  if (!m_connections.empty() && !m_taskTimeout.is_queued())
+    priority_queue_insert(&m_thread->task_scheduler(),
+                          &m_taskTimeout,
+                          cachedTime + torrent::utils::timer::from_seconds(1));
+}
+
+// Called with 'm_lock' held. A connection that failed or stalled is
+// shut down, so the loop doesn't go on sending after a partial
+// response.
+void
+SCgiSender::close_connection(Connection* connection, bool shutdown) {
+  if (connection->is_polled()) {
+    m_thread->poll()->remove_write(connection);
+    m_thread->poll()->remove_error(connection);
+    m_thread->poll()->close(connection);
+  }
+
+  if (shutdown)
+    ::shutdown(connection->file_descriptor(), SHUT_RDWR);
+
+  ::close(connection->file_descriptor());
+
+  m_connections.erase(
+    std::find(m_connections.begin(), m_connections.end(), connection));
+  m_size.store(m_connections.size(), std::memory_order_relaxed);
+
+  delete connection;
+}
+
+void
+SCgiSender::receive_timeout() {
+  std::lock_guard<std::mutex> guard(m_lock);
+
+  auto timeout = torrent::utils::timer::from_milliseconds(send_timeout);
+
+  for (size_t i = 0; i < m_connections.size();) {
+    Connection* connection = m_connections[i];
+
+    if (connection->is_polled() &&
+        connection->last_progress() + timeout <= cachedTime)
+      close_connection(connection, true);
+    else
+      i++;
+  }
+
+  if (!m_connections.empty())
+    priority_queue_insert(&m_thread->task_scheduler(),
+                          &m_taskTimeout,
+                          cachedTime + torrent::utils::timer::from_seconds(1));
+}
+
+}
@@ -36,18 +36,23 @@ SCgiTask::realloc_buffer(uint32_t    size,
   }
 
   ::free(m_buffer);
-  m_buffer = tmp;
+  m_buffer         = tmp;
+  m_bufferCapacity = size;
 }
 
 void
 SCgiTask::open(SCgi* parent, int fd) {
   m_parent   = parent;
   m_fileDesc = fd;
+  m_generation++;
   m_buffer   = torrent::utils::cacheline_allocator<char>::alloc_size(
     (m_bufferSize = default_buffer_size) + 1);
   m_position = m_buffer;
   m_body     = nullptr;
 
+  m_bufferCapacity = default_buffer_size + 1;
+  m_pipelined.clear();
+
   worker_thread->poll()->open(this);
   worker_thread->poll()->insert_read(this);
   worker_thread->poll()->insert_error(this);
@@ -65,12 +70,17 @@ SCgiTask::close() {
   worker_thread->poll()->remove_error(this);
   worker_thread->poll()->close(this);
 
+  priority_queue_erase(worker_thread->task_scheduler(), &m_taskIdle);
+
   get_fd().close();
   get_fd().clear();
 
   ::free(m_buffer);
   m_buffer = nullptr;
 
+  m_pipelined.clear();
+  m_parent->release_task(this);
+
   // Test
   //   char buffer[512];
   //   sprintf(buffer, "SCgi system call processed: %i",
@@ -95,6 +105,11 @@ SCgiTask::event_read() {
   m_position += bytes;
   *m_position = '\0';
 
+  process_read();
+}
+
+void
+SCgiTask::process_read() {
   if (m_body == nullptr) {
     // Don't bother caching the parsed values, as we're likely to
     // receive all the data we need the first time.
@@ -183,11 +198,22 @@ SCgiTask::event_read() {
     }
   }
 
-  if ((unsigned int)std::distance(m_buffer, m_position) != m_bufferSize)
+  if ((unsigned int)std::distance(m_buffer, m_position) < m_bufferSize)
     return;
 
+  if ((unsigned int)std::distance(m_buffer, m_position) > m_bufferSize) {
+    // The client sent the start of another request, keep it for after
+    // the response if the connection is persistent.
+    if (m_parent->is_keep_alive())
+      m_pipelined.assign(m_buffer + m_bufferSize, m_position);
+
+    m_position = m_buffer + m_bufferSize;
+  }
+
+  // Writing is enabled once the response is ready, which may be
+  // after the call returns if a worker thread executes it.
   worker_thread->poll()->remove_read(this);
-  worker_thread->poll()->insert_write(this);
+  priority_queue_erase(worker_thread->task_scheduler(), &m_taskIdle);
 
   if (m_parent->log_fd() >= 0) {
     ssize_t __attribute__((unused)) result;
@@ -231,10 +257,45 @@ SCgiTask::event_write() {
   m_position += bytes;
   m_bufferSize -= bytes;
 
+  if (m_bufferSize == 0 && m_parent->is_keep_alive())
+    return restart();
+
   if (bytes == 0 || m_bufferSize == 0)
     return close();
 }
 
+// Prepare for the next request on a persistent connection, reusing
+// the buffer unless a large request or response grew it.
+void
+SCgiTask::restart() {
+  worker_thread->poll()->remove_write(this);
+  worker_thread->poll()->insert_read(this);
+
+  if (m_bufferCapacity > default_buffer_size + 1)
+    realloc_buffer(default_buffer_size + 1);
+
+  m_bufferSize = default_buffer_size;
+  m_position   = m_buffer;
+  m_body       = nullptr;
+
+  priority_queue_insert(
+    worker_thread->task_scheduler(),
+    &m_taskIdle,
+    cachedTime +
+      torrent::utils::timer::from_seconds(m_parent->keep_alive_timeout()));
+
+  if (m_pipelined.empty())
+    return;
+
+  std::memcpy(m_buffer, m_pipelined.data(), m_pipelined.size());
+
+  m_position += m_pipelined.size();
+  *m_position = '\0';
+  m_pipelined.clear();
+
+  process_read();
+}
+
 void
 SCgiTask::event_error() {
   close();
@@ -246,7 +307,7 @@ SCgiTask::receive_write(const char* buffer, uint32_t length) {
     throw torrent::internal_error(
       "SCgiTask::receive_write(...) received bad input.");
 
-  if (length + 256 > std::max(m_bufferSize, default_buffer_size))
+  if (length + 256 > m_bufferCapacity)
     realloc_buffer(length + 256);
 
   const auto header = m_type == ContentType::JSON
@@ -274,6 +335,7 @@ SCgiTask::receive_write(const char* buffer, uint32_t length) {
   lt_log_print_dump(
     torrent::LOG_RPC_DUMP, m_buffer, m_bufferSize, "scgi", "RPC write.", 0);
 
+  worker_thread->poll()->insert_write(this);
   event_write();
   return true;
 }
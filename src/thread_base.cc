@@ -5,7 +5,6 @@
 
 #include <cassert>
 #include <cstdlib>
-#include <cstring>
 #include <iostream>
 #include <signal.h>
 #include <torrent/exceptions.h>
@@ -19,72 +18,6 @@
 #include "core/manager.h"
 #include "globals.h"
 
-class lt_cacheline_aligned thread_queue_hack {
-public:
-  using value_type = ThreadBase::thread_base_func;
-  using iterator   = ThreadBase::thread_base_func*;
-
-  static constexpr unsigned int max_size = 32;
-
-  thread_queue_hack() {
-    std::memset(this, 0, sizeof(thread_queue_hack));
-  }
-
-  void lock() {
-    while (!__sync_bool_compare_and_swap(&m_lock, 0, 1))
-      usleep(0);
-  }
-  void unlock() {
-    __sync_bool_compare_and_swap(&m_lock, 1, 0);
-  }
-
-  iterator begin() {
-    return m_queue;
-  }
-  iterator max_capacity() {
-    return m_queue + max_size;
-  }
-
-  iterator end_and_lock() {
-    lock();
-    return std::find(begin(), max_capacity(), (value_type) nullptr);
-  }
-
-  bool empty() const {
-    return m_queue[0] == nullptr;
-  }
-
-  void push_back(value_type v) {
-    iterator itr = end_and_lock();
-
-    if (itr == max_capacity())
-      throw torrent::internal_error("Overflowed thread_queue.");
-
-    __sync_bool_compare_and_swap(itr, nullptr, v);
-    unlock();
-  }
-
-  value_type* copy_and_clear(value_type* dest) {
-    iterator itr = begin();
-    lock();
-
-    while (*itr != nullptr)
-      *dest++ = *itr++;
-
-    clear_and_unlock();
-    return dest;
-  }
-
-  void clear_and_unlock() {
-    std::memset(this, 0, sizeof(thread_queue_hack));
-    __sync_synchronize();
-  }
-
-private:
-  int        m_lock;
-  value_type m_queue[max_size + 1];
-};
-
 void
 throw_shutdown_exception() {
   throw torrent::shutdown_exception();
@@ -92,13 +25,9 @@ throw_shutdown_exception() {
 
 ThreadBase::ThreadBase() {
   m_taskShutdown.slot() = [] { return throw_shutdown_exception(); };
-
-  m_threadQueue = new thread_queue_hack;
 }
 
-ThreadBase::~ThreadBase() {
-  delete m_threadQueue;
-}
+ThreadBase::~ThreadBase() = default;
 
 // Move to libtorrent...
 void
@@ -120,19 +49,13 @@ ThreadBase::next_timeout_usec() {
 
 void
 ThreadBase::call_queued_items() {
-  thread_base_func  result[thread_queue_hack::max_size];
-  thread_base_func* first = result;
-  thread_base_func* last =
-    m_threadQueue->copy_and_clear((thread_base_func*)result);
-
-  while (first != last && *first)
-    (*first++)(this);
+  m_threadQueue.consume([this](thread_base_func func) { func(this); });
 }
 
 void
 ThreadBase::call_events() {
   // Check for new queued items set by other threads.
-  if (!m_threadQueue->empty())
+  if (!m_threadQueue.empty())
     call_queued_items();
 
   torrent::utils::priority_queue_perform(&m_taskScheduler, cachedTime);
@@ -140,7 +63,7 @@ ThreadBase::call_events() {
 
 void
 ThreadBase::queue_item(thread_base_func newFunc) {
-  m_threadQueue->push_back(newFunc);
+  m_threadQueue.push(std::move(newFunc));
 
   // Make it also restart inactive threads?
   if (m_state == STATE_ACTIVE)
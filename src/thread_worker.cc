@@ -66,6 +66,21 @@ ThreadWorker::msg_change_rpc_log(ThreadBase* baseThread) {
   thread->change_rpc_log();
 }
 
+void
+ThreadWorker::msg_open_scgi_sender(ThreadBase* baseThread) {
+  ThreadWorker* thread = (ThreadWorker*)baseThread;
+
+  thread->m_scgiSender.open_connections();
+}
+
+void
+ThreadWorker::msg_deliver_responses(ThreadBase* baseThread) {
+  ThreadWorker* thread = (ThreadWorker*)baseThread;
+
+  if (thread->protocol() != nullptr)
+    ((rpc::SCgi*)(thread->protocol()))->deliver_responses();
+}
+
 void
 ThreadWorker::change_rpc_log() {
   auto work_protocol = static_cast<rpc::SCgi*>(protocol());
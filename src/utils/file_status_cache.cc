@@ -29,34 +29,91 @@ FileStatusCache::insert(const std::string& path, bool shouldThrow) {
     return true;
   }
 
-  std::pair<iterator, bool> result =
-    base_type::insert(value_type(path, file_status()));
+  size_t split = path.rfind('/') + 1;
+
+  uint32_t directory = directory_id(path.substr(0, split));
+  auto     result    = m_directories[directory].files.emplace(
+    path.substr(split), m_entries.size());
+
+  if (result.second) {
+    if (!m_free.empty()) {
+      result.first->second = m_free.back();
+      m_free.pop_back();
+    } else {
+      m_entries.emplace_back();
+    }
+
+    m_entries[result.first->second] =
+      entry_type{ &result.first->first, directory, 0 };
+    m_size++;
+  }
+
+  entry_type& entry = m_entries[result.first->second];
 
   // Return false if the file hasn't been modified since last time. We
   // use 'equal to' instead of 'greater than' since the file might
   // have been replaced by another file, and thus should be re-tried.
-  if (!result.second &&
-      result.first->second.m_mtime == (uint32_t)fs.modified_time())
+  if (!result.second && entry.mtime == (uint32_t)fs.modified_time())
     return false;
 
-  result.first->second.m_flags = 0;
-  result.first->second.m_mtime = fs.modified_time();
+  entry.mtime = fs.modified_time();
 
   return true;
 }
 
-void
-FileStatusCache::prune() {
-  iterator itr = begin();
+bool
+FileStatusCache::prune_step(size_t count) {
+  for (; count != 0; count--) {
+    if (m_cursor >= m_entries.size()) {
+      m_cursor = 0;
+      return true;
+    }
+
+    uint32_t    index = m_cursor++;
+    entry_type& entry = m_entries[index];
+
+    if (entry.name == nullptr)
+      continue;
 
-  while (itr != end()) {
     torrent::utils::file_stat fs;
-    iterator                  tmp = itr++;
+    std::string path = m_directories[entry.directory].path + *entry.name;
 
-    if (!fs.update(torrent::utils::path_expand(tmp->first)) ||
-        tmp->second.m_mtime != (uint32_t)fs.modified_time())
-      base_type::erase(tmp);
+    if (!fs.update(torrent::utils::path_expand(path)) ||
+        entry.mtime != (uint32_t)fs.modified_time())
+      erase_entry(index);
   }
+
+  return false;
+}
+
+void
+FileStatusCache::prune() {
+  m_cursor = 0;
+
+  while (!prune_step(m_entries.size() + 1))
+    ;
+}
+
+uint32_t
+FileStatusCache::directory_id(const std::string& path) {
+  auto result = m_directoryIndex.emplace(path, m_directories.size());
+
+  if (result.second)
+    m_directories.push_back(directory_type{ path, file_map() });
+
+  return result.first->second;
+}
+
+void
+FileStatusCache::erase_entry(uint32_t index) {
+  entry_type& entry = m_entries[index];
+
+  file_map& files = m_directories[entry.directory].files;
+  files.erase(files.find(*entry.name));
+
+  entry.name = nullptr;
+  m_free.push_back(index);
+  m_size--;
 }
 
 }
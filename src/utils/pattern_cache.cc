@@ -0,0 +1,164 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+// Copyright (C) 2021, Contributors to the rTorrent project
+
+#include <algorithm>
+#include <cstring>
+
+#include "utils/pattern_cache.h"
+
+namespace utils {
+
+static bool
+pattern_is_special(char c) {
+  return std::strchr("\\^$.|?*+()[]{}", c) != nullptr;
+}
+
+// Unescape 'first' to 'last' into 'dest', returning false if the
+// range contains anything but plain or escaped literal characters.
+static bool
+pattern_to_literal(std::string::const_iterator first,
+                   std::string::const_iterator last,
+                   std::string*                dest) {
+  while (first != last) {
+    if (*first == '\\') {
+      if (++first == last || !pattern_is_special(*first))
+        return false;
+    } else if (pattern_is_special(*first)) {
+      return false;
+    }
+
+    dest->push_back(*first++);
+  }
+
+  return true;
+}
+
+// Returns true if the pattern ends with an unescaped '.*'.
+static bool
+pattern_has_trailing_any(const std::string& pattern, size_t min_size) {
+  if (pattern.size() < min_size + 2 ||
+      pattern.compare(pattern.size() - 2, 2, ".*") != 0)
+    return false;
+
+  size_t escapes = 0;
+
+  for (auto itr = pattern.rbegin() + 2;
+       itr != pattern.rend() - min_size && *itr == '\\';
+       itr++)
+    escapes++;
+
+  return (escapes & 0x1) == 0;
+}
+
+// ECMAScript '.' does not match line terminators.
+static bool
+pattern_dot_match(const char* first, const char* last) {
+  return std::find_if(first, last, [](char c) {
+           return c == '\n' || c == '\r';
+         }) == last;
+}
+
+Pattern::Pattern(const std::string& pattern) {
+  bool leading  = pattern.size() >= 2 && pattern.compare(0, 2, ".*") == 0;
+  bool trailing = pattern_has_trailing_any(pattern, leading ? 2 : 0);
+
+  auto first = pattern.begin() + (leading ? 2 : 0);
+  auto last  = pattern.end() - (trailing ? 2 : 0);
+
+  if (pattern_to_literal(first, last, &m_literal)) {
+    if (leading && trailing)
+      m_type = match_contains;
+    else if (leading)
+      m_type = match_suffix;
+    else if (trailing)
+      m_type = match_prefix;
+    else
+      m_type = match_literal;
+
+    return;
+  }
+
+  m_literal.clear();
+
+  try {
+    m_regex = std::regex(pattern);
+    m_type  = match_regex;
+  } catch (const std::regex_error& e) {
+    m_type  = match_invalid;
+    m_error = e.what();
+  }
+}
+
+bool
+Pattern::match(const std::string& str) const {
+  const char* first = str.c_str();
+  const char* last  = str.c_str() + str.size();
+
+  switch (m_type) {
+    case match_literal:
+      return str == m_literal;
+
+    case match_prefix:
+      return str.size() >= m_literal.size() &&
+             str.compare(0, m_literal.size(), m_literal) == 0 &&
+             pattern_dot_match(first + m_literal.size(), last);
+
+    case match_suffix:
+      return str.size() >= m_literal.size() &&
+             str.compare(
+               str.size() - m_literal.size(), m_literal.size(), m_literal) ==
+               0 &&
+             pattern_dot_match(first, last - m_literal.size());
+
+    case match_contains: {
+      if (!pattern_dot_match(first, last))
+        return false;
+
+      return str.find(m_literal) != std::string::npos;
+    }
+
+    case match_regex:
+      return std::regex_match(str, m_regex);
+
+    default:
+      return false;
+  }
+}
+
+std::pair<PatternCache::pointer, bool>
+PatternCache::insert(const std::string& pattern) {
+  std::lock_guard<std::mutex> lock(m_mutex);
+
+  auto itr = m_patterns.find(pattern);
+
+  if (itr != m_patterns.end())
+    return std::make_pair(itr->second, false);
+
+  if (m_patterns.size() >= max_size)
+    m_patterns.clear();
+
+  auto result = std::make_shared<const Pattern>(pattern);
+  m_patterns.emplace(pattern, result);
+
+  return std::make_pair(result, true);
+}
+
+size_t
+PatternCache::size() const {
+  std::lock_guard<std::mutex> lock(m_mutex);
+  return m_patterns.size();
+}
+
+void
+PatternCache::clear() {
+  std::lock_guard<std::mutex> lock(m_mutex);
+  m_patterns.clear();
+}
+
+PatternCache&
+pattern_cache() {
+  static PatternCache cache;
+  return cache;
+}
+
+}
@@ -6,25 +6,40 @@
 #include "rpc/scgi.h"
 
 #include <torrent/utils/path.h>
+#include <algorithm>
 #include <fcntl.h>
+#include "nlohmann/json.hpp"
 
 using namespace uWS;
 
 WebsocketsThread::~WebsocketsThread() {
+  // The bus is opened once 'm_loop' is set.
+  bool running = m_event_bus.is_open();
+
+  m_event_bus.close();
+
+  // close all websocket connection and then close the listen socket
+  // from the loop, then 'm_websockets_app->run()' will return, join the
+  // thread next. Closing removes the connection from 'all_connection',
+  // so iterate over a copy.
+  if (running) {
+    m_loop->defer([this]() {
+      auto connections = all_connection;
+      std::for_each(connections.begin(), connections.end(), [](auto connection) {
+          connection->close();
+      });
+      us_listen_socket_close(0, m_listen_socket);
+    });
+  }
 
-  // close all websocket connection and then close the listen socket,
-  // then 'm_websockets_app->run()' will return, join the thread next.
-  std::for_each(all_connection.begin(), all_connection.end(), [](auto connection) {
-      connection->close();
-  });
-  us_listen_socket_close(0, m_listen_socket);
+  if (m_websockets_thread && m_websockets_thread->joinable()) {
+    m_websockets_thread->join();
+  }
 
+  // Deleted after the join, as callbacks deferred earlier, like the
+  // event bus drain, publish through the app.
   delete listen_info;
   delete m_websockets_app;
-
-  if (m_websockets_thread->joinable()) {
-    m_websockets_thread->join();
-  }
 }
 
 bool
@@ -73,13 +88,24 @@ WebsocketsThread::start_thread() {
     App::WebSocketBehavior<ConnectionData> behavior;
     behavior.open = [&](WebSocket<false, true, ConnectionData>* ws) {
       ws->subscribe("event.*");
+      m_event_bus.subscribe("event.*");
+      ws->getUserData()->topics.emplace_back("event.*");
       all_connection.emplace_back(ws);
       ws->getUserData()->address = ws->getRemoteAddressAsText();
     };
     behavior.message = [&](WebSocket<false, true, ConnectionData>* ws, std::string_view request, OpCode) {
+      if (handle_subscription(ws, request))
+        return;
+
       m_websocket_connection = ws;
       handle_request(request);
     };
+    behavior.close = [&](WebSocket<false, true, ConnectionData>* ws, int, std::string_view) {
+      for (const auto& topic : ws->getUserData()->topics)
+        m_event_bus.unsubscribe(topic);
+
+      all_connection.erase(std::remove(all_connection.begin(), all_connection.end(), ws), all_connection.end());
+    };
 
     m_websockets_app->ws("/*", std::move(behavior));
 
@@ -100,6 +126,12 @@ WebsocketsThread::start_thread() {
 
     m_loop = Loop::get();
 
+    m_event_bus.open(
+      [this](std::function<void()> func) { m_loop->defer(std::move(func)); },
+      [this](std::string_view topic, std::string_view message) {
+        m_websockets_app->publish(topic, message, OpCode::TEXT);
+      });
+
     if (m_listen_socket) m_websockets_app->run();
     else throw torrent::internal_error("Can't make websockets server run !!!");
   };
@@ -110,14 +142,94 @@ WebsocketsThread::start_thread() {
 
 void
 WebsocketsThread::handle_request(const std::string_view& request) {
-  rpc::rpc.dispatch(rpc::RpcManager::RPCType::JSON, request.data(), request.length(), [&](const char* response, uint32_t) {
-    return m_websocket_connection->send(std::string_view(response), uWS::OpCode::TEXT);
+  auto ws = m_websocket_connection;
+
+  // Read-only requests are executed by the RPC workers, the response is
+  // sent from the loop as long as the connection is still open.
+  auto send_later = [this, ws](std::string&& response) {
+    m_loop->defer([this, ws, response = std::move(response)]() {
+      if (std::find(all_connection.begin(), all_connection.end(), ws) != all_connection.end())
+        ws->send(response, uWS::OpCode::TEXT);
+    });
+  };
+
+  if (rpc::rpc.dispatch_readonly(rpc::RpcManager::RPCType::JSON, request.data(), request.length(), send_later))
+    return;
+
+  rpc::rpc.dispatch(rpc::RpcManager::RPCType::JSON, request.data(), request.length(), [&](const char* response, uint32_t length) {
+    return m_websocket_connection->send(std::string_view(response, length), uWS::OpCode::TEXT);
   });
 }
 
+// Control messages are JSON-RPC calls of 'subscribe' or 'unsubscribe'
+// with a list of topics. They only change which frames the connection
+// receives, so they are handled on the loop instead of being
+// dispatched. The result is the list of topics the connection is
+// subscribed to.
+bool
+WebsocketsThread::handle_subscription(WebSocket<false, true, ConnectionData>* ws, std::string_view request) {
+  if (request.find("subscribe\"") == std::string_view::npos)
+    return false;
+
+  auto message = nlohmann::json::parse(request, nullptr, false);
+
+  if (!message.is_object() || !message.contains("method") || !message["method"].is_string())
+    return false;
+
+  const auto method = message["method"].get<std::string>();
+
+  if (method != "subscribe" && method != "unsubscribe")
+    return false;
+
+  nlohmann::json response = { { "jsonrpc", "2.0" }, { "id", message.value("id", nlohmann::json()) } };
+  nlohmann::json params   = message.value("params", nlohmann::json::array());
+
+  if (!params.is_array())
+    params = nlohmann::json::array({ params });
+
+  std::vector<std::string> topics;
+
+  for (const auto& param : params) {
+    auto topic = param.is_string() ? rpc::EventBus::normalize_topic(param.get<std::string>()) : std::string();
+
+    if (topic.empty()) {
+      response["error"] = { { "code", -32602 }, { "message", "Invalid topic: " + param.dump() } };
+      ws->send(response.dump(), OpCode::TEXT);
+      return true;
+    }
+
+    topics.push_back(std::move(topic));
+  }
+
+  auto& subscribed = ws->getUserData()->topics;
+
+  for (const auto& topic : topics) {
+    auto itr = std::find(subscribed.begin(), subscribed.end(), topic);
+
+    if (method == "subscribe" && itr == subscribed.end()) {
+      ws->subscribe(topic);
+      m_event_bus.subscribe(topic);
+      subscribed.push_back(topic);
+
+    } else if (method == "unsubscribe" && itr != subscribed.end()) {
+      ws->unsubscribe(topic);
+      m_event_bus.unsubscribe(topic);
+      subscribed.erase(itr);
+    }
+  }
+
+  response["result"] = subscribed;
+  ws->send(response.dump(), OpCode::TEXT);
+  return true;
+}
+
 void WebsocketsThread::publish_ws_topic(std::string_view topic, std::string_view message) {
-  // `m_websockets_app` maybe uninitialized when some events happen so null check is required here
-  if (m_websockets_app) {
+  // The app is only set up once the loop runs, and has to be published
+  // to from the loop thread.
+  if (!m_event_bus.is_open())
+    return;
+
+  m_loop->defer([this, topic = std::string(topic), message = std::string(message)]() {
     m_websockets_app->publish(topic, message, OpCode::TEXT);
-  }
+  });
 }
\ No newline at end of file
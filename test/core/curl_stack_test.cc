@@ -0,0 +1,150 @@
+#include <arpa/inet.h>
+#include <atomic>
+#include <curl/curl.h>
+#include <netinet/in.h>
+#include <poll.h>
+#include <string>
+#include <sys/socket.h>
+#include <thread>
+#include <unistd.h>
+
+#include "core/curl_stack.h"
+#include "test/core/curl_stack_test.h"
+
+// Stand-in HTTP/1.1 server answering every request with an empty
+// bencoded dictionary on a kept-alive connection, counting the
+// connections accepted.
+class LocalHttpServer {
+public:
+  LocalHttpServer() {
+    sockaddr_in address{};
+    address.sin_family      = AF_INET;
+    address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+
+    socklen_t length = sizeof(address);
+
+    m_fd = ::socket(AF_INET, SOCK_STREAM, 0);
+    ::bind(m_fd, (sockaddr*)&address, sizeof(address));
+    ::listen(m_fd, 16);
+    ::getsockname(m_fd, (sockaddr*)&address, &length);
+
+    m_port   = ntohs(address.sin_port);
+    m_thread = std::thread([this] { run(); });
+  }
+
+  ~LocalHttpServer() {
+    m_stop = true;
+    m_thread.join();
+    ::close(m_fd);
+  }
+
+  std::string url() const {
+    return "http://127.0.0.1:" + std::to_string(m_port) + "/file.torrent";
+  }
+
+  unsigned int connections() const {
+    return m_connections;
+  }
+
+private:
+  bool wait_readable(int fd) {
+    pollfd pfd{ fd, POLLIN, 0 };
+
+    while (!m_stop)
+      if (::poll(&pfd, 1, 10) > 0)
+        return true;
+
+    return false;
+  }
+
+  void run() {
+    while (wait_readable(m_fd)) {
+      int fd = ::accept(m_fd, nullptr, nullptr);
+
+      if (fd == -1)
+        continue;
+
+      m_connections++;
+      serve(fd);
+      ::close(fd);
+    }
+  }
+
+  void serve(int fd) {
+    std::string request;
+    char        buffer[4096];
+
+    while (wait_readable(fd)) {
+      ssize_t bytes = ::read(fd, buffer, sizeof(buffer));
+
+      if (bytes <= 0)
+        return;
+
+      request.append(buffer, bytes);
+
+      for (size_t end; (end = request.find("\r\n\r\n")) != std::string::npos;) {
+        request.erase(0, end + 4);
+
+        const char response[] =
+          "HTTP/1.1 200 OK\r\nContent-Length: 2\r\n\r\nde";
+
+        if (::write(fd, response, sizeof(response) - 1) == -1)
+          return;
+      }
+    }
+  }
+
+  int                       m_fd;
+  int                       m_port;
+  std::atomic<bool>         m_stop{ false };
+  std::atomic<unsigned int> m_connections{ 0 };
+  std::thread               m_thread;
+};
+
+static size_t
+curl_stack_test_write(void*, size_t size, size_t nmemb, void*) {
+  return size * nmemb;
+}
+
+static bool
+fetch(core::CurlStack* stack, const std::string& url) {
+  CURL* handle = curl_easy_init();
+
+  curl_easy_setopt(handle, CURLOPT_URL, url.c_str());
+  curl_easy_setopt(handle, CURLOPT_WRITEFUNCTION, &curl_stack_test_write);
+  curl_easy_setopt(handle, CURLOPT_NOSIGNAL, (long)1);
+  stack->prepare_handle(handle);
+
+  bool result = curl_easy_perform(handle) == CURLE_OK;
+
+  curl_easy_cleanup(handle);
+  return result;
+}
+
+void
+CurlStackTest::SetUp() {
+  core::CurlStack::global_init();
+}
+
+TEST_F(CurlStackTest, test_reuse_connections) {
+  LocalHttpServer server;
+
+  {
+    core::CurlStack stack;
+
+    for (int i = 0; i < 3; i++)
+      ASSERT_TRUE(fetch(&stack, server.url()));
+
+    ASSERT_EQ(server.connections(), 3u);
+  }
+
+  {
+    core::CurlStack stack;
+    stack.set_reuse_connections(true);
+
+    for (int i = 0; i < 3; i++)
+      ASSERT_TRUE(fetch(&stack, server.url()));
+
+    ASSERT_EQ(server.connections(), 4u);
+  }
+}
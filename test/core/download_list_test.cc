@@ -0,0 +1,115 @@
+#include <torrent/utils/string_manip.h>
+
+#include "test/core/download_list_test.h"
+
+core::Download*
+DownloadListTest::download(unsigned int i) {
+  return reinterpret_cast<core::Download*>((i + 1) * 8);
+}
+
+torrent::HashString
+DownloadListTest::hash(unsigned int i) {
+  torrent::HashString result;
+
+  for (unsigned int j = 0; j < torrent::HashString::size_data; j++)
+    result.data()[j] = (char)((i >> (8 * (j % 4))) + j);
+
+  return result;
+}
+
+std::string
+DownloadListTest::hex(unsigned int i) {
+  torrent::HashString h = hash(i);
+  return torrent::utils::transform_hex(h.begin(), h.end());
+}
+
+void
+DownloadListTest::insert(unsigned int i, unsigned int hash_of) {
+  m_list.insert_indexed(download(i), hash(hash_of));
+}
+
+void
+DownloadListTest::erase(unsigned int i) {
+  m_list.erase_indexed(m_list.find(hash(i)), hash(i));
+}
+
+void
+DownloadListTest::erase_ptr(unsigned int i, unsigned int hash_of) {
+  m_list.erase_indexed(m_list.find_indexed(download(i), hash(hash_of)),
+                       hash(hash_of));
+}
+
+core::Download*
+DownloadListTest::find(unsigned int i) {
+  auto itr = m_list.find(hash(i));
+  return itr != m_list.end() ? *itr : nullptr;
+}
+
+core::Download*
+DownloadListTest::find_hex(unsigned int i) {
+  return m_list.find_hex_ptr(hex(i).c_str());
+}
+
+TEST_F(DownloadListTest, test_find) {
+  for (unsigned int i = 0; i < 1000; i++)
+    insert(i);
+
+  ASSERT_EQ(index_size(), 1000u);
+
+  for (unsigned int i = 0; i < 1000; i++) {
+    ASSERT_EQ(find(i), download(i));
+    ASSERT_EQ(find_hex(i), download(i));
+  }
+
+  ASSERT_EQ(find(1000), nullptr);
+  ASSERT_EQ(find_hex(1000), nullptr);
+}
+
+TEST_F(DownloadListTest, test_erase) {
+  for (unsigned int i = 0; i < 100; i++)
+    insert(i);
+
+  for (unsigned int i = 0; i < 100; i += 3)
+    erase(i);
+
+  for (unsigned int i = 1; i < 100; i += 3)
+    erase_ptr(i, i);
+
+  ASSERT_EQ(m_list.size(), 33u);
+  ASSERT_EQ(index_size(), m_list.size());
+
+  for (unsigned int i = 0; i < 100; i++) {
+    auto expected = i % 3 == 2 ? download(i) : nullptr;
+
+    ASSERT_EQ(find(i), expected);
+    ASSERT_EQ(find_hex(i), expected);
+  }
+
+  // Erased downloads may be inserted again.
+  insert(0);
+
+  ASSERT_EQ(find(0), download(0));
+  ASSERT_EQ(index_size(), m_list.size());
+}
+
+// A download inserted again before the old entry is gone replaces it
+// in the index, which erasing the old entry has to leave alone.
+TEST_F(DownloadListTest, test_erase_replaced) {
+  insert(0);
+  insert(1, 0);
+
+  ASSERT_EQ(m_list.size(), 2u);
+  ASSERT_EQ(find(0), download(1));
+
+  erase_ptr(0, 0);
+
+  ASSERT_EQ(m_list.size(), 1u);
+  ASSERT_EQ(find(0), download(1));
+  ASSERT_EQ(find_hex(0), download(1));
+
+  erase_ptr(1, 0);
+
+  ASSERT_TRUE(m_list.empty());
+  ASSERT_EQ(index_size(), 0u);
+  ASSERT_EQ(find(0), nullptr);
+}
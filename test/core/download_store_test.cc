@@ -0,0 +1,142 @@
+#include <chrono>
+#include <fstream>
+#include <iostream>
+#include <unistd.h>
+
+#include <torrent/object_stream.h>
+
+#include "core/download_store.h"
+#include "test/core/download_store_test.h"
+
+// Roughly the size of the resume data of a large torrent.
+static torrent::Object
+make_resume(unsigned int files) {
+  torrent::Object resume = torrent::Object::create_map();
+  resume.insert_key("bitfield", std::string(files * 64, 'x'));
+
+  torrent::Object::list_type& list =
+    resume.insert_key("files", torrent::Object::create_list()).as_list();
+
+  for (unsigned int i = 0; i < files; i++) {
+    list.push_back(torrent::Object::create_map());
+
+    torrent::Object& file = list.back();
+    file.insert_key("completed", int64_t(i));
+    file.insert_key("mtime", int64_t(1600000000 + i));
+    file.insert_key("priority", int64_t(1));
+  }
+
+  return resume;
+}
+
+// The previous DownloadStore::write_bencode, which read every file back
+// to check it.
+static bool
+write_bencode_read_back(const std::string&     filename,
+                        const torrent::Object& obj) {
+  torrent::Object tmp;
+  std::fstream    output((filename + ".new").c_str(),
+                      std::ios::out | std::ios::trunc);
+
+  torrent::object_write_bencode(&output, &obj, 0);
+
+  if (!output.good())
+    return false;
+
+  output.close();
+  output.open((filename + ".new").c_str(), std::ios::in);
+  output >> tmp;
+
+  if (!output.good())
+    return false;
+
+  return ::rename((filename + ".new").c_str(), filename.c_str()) == 0;
+}
+
+// Prints the time taken to write resume files when reading them back
+// against storing a checksum, run it with
+// --gtest_also_run_disabled_tests.
+TEST_F(DownloadStoreTest, DISABLED_benchmark_write_bencode) {
+  constexpr unsigned int torrents = 200;
+
+  auto resume = make_resume(2000);
+
+  for (unsigned int pass = 0; pass < 2; pass++) {
+    auto start = std::chrono::steady_clock::now();
+
+    for (unsigned int i = 0; i < torrents; i++) {
+      auto filename = m_directory.path() + "/" + std::to_string(i) + ".resume";
+
+      ASSERT_TRUE(pass == 0 ? write_bencode_read_back(filename, resume)
+                            : core::DownloadStore::write_bencode(
+                                filename, resume, 0));
+    }
+
+    auto duration = std::chrono::duration<double>(
+                      std::chrono::steady_clock::now() - start)
+                      .count();
+
+    std::cout << (pass == 0 ? "read back: " : "checksum:  ") << torrents
+              << " resume files in " << duration * 1000 << " ms, "
+              << torrents / duration << " torrents/s" << std::endl;
+  }
+
+  torrent::Object object;
+  std::ifstream   input(m_directory.path() + "/0.resume");
+  input >> object;
+
+  ASSERT_TRUE(input.good());
+  ASSERT_EQ(object.get_key_list("files").size(), 2000u);
+}
+
+// The checksum is a key of the bencoded dictionary, so other decoders
+// still read the file.
+TEST_F(DownloadStoreTest, read_bencode_checksum) {
+  auto filename = m_directory.path() + "/checksum.resume";
+  auto resume   = make_resume(10);
+
+  ASSERT_TRUE(core::DownloadStore::write_bencode(filename, resume, 0));
+
+  torrent::Object plain;
+  std::ifstream   input(filename.c_str());
+  input >> plain;
+
+  ASSERT_TRUE(input.good());
+  ASSERT_TRUE(plain.has_key_value("~crc32"));
+
+  torrent::Object object;
+  ASSERT_TRUE(core::DownloadStore::read_bencode(filename, &object));
+  ASSERT_FALSE(object.has_key("~crc32"));
+  ASSERT_EQ(object.get_key_list("files").size(), 10u);
+}
+
+TEST_F(DownloadStoreTest, read_bencode_corrupt) {
+  auto filename = m_directory.path() + "/corrupt.resume";
+  auto resume   = make_resume(10);
+
+  ASSERT_TRUE(core::DownloadStore::write_bencode(filename, resume, 0));
+
+  // Flip a byte inside the bitfield, which still decodes.
+  std::fstream file(filename.c_str(),
+                    std::ios::in | std::ios::out | std::ios::binary);
+  file.seekp(20);
+  file.put('y');
+  file.close();
+
+  torrent::Object object;
+  ASSERT_FALSE(core::DownloadStore::read_bencode(filename, &object));
+  ASSERT_TRUE(object.is_empty());
+}
+
+TEST_F(DownloadStoreTest, read_bencode_without_checksum) {
+  auto filename = m_directory.path() + "/plain.resume";
+  auto resume   = make_resume(10);
+
+  std::fstream output(filename.c_str(), std::ios::out | std::ios::trunc);
+  torrent::object_write_bencode(&output, &resume, 0);
+  output.close();
+
+  torrent::Object object;
+  ASSERT_TRUE(core::DownloadStore::read_bencode(filename, &object));
+  ASSERT_EQ(object.get_key_list("files").size(), 10u);
+}
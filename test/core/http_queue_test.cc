@@ -0,0 +1,136 @@
+#include <algorithm>
+
+#include "core/curl_get.h"
+#include "test/core/http_queue_test.h"
+
+void
+HttpQueueTest::SetUp() {
+  core::CurlStack::global_init();
+
+  m_stack = std::make_unique<core::CurlStack>();
+  m_stack->set_max_active(0);
+
+  m_queue.set_slot_factory(
+    [this]() { return new core::CurlGet(m_stack.get()); });
+}
+
+void
+HttpQueueTest::TearDown() {
+  m_queue.clear();
+  m_stack.reset();
+}
+
+core::CurlGet*
+HttpQueueTest::insert(const std::string& url, int priority) {
+  return *m_queue.insert(url, &m_stream, priority);
+}
+
+// Stands in for the transfer being done or failing.
+void
+HttpQueueTest::finish(core::CurlGet* http) {
+  m_queue.erase(std::find(m_queue.begin(), m_queue.end(), http));
+}
+
+TEST_F(HttpQueueTest, test_priority_order) {
+  m_queue.set_max_active(1);
+
+  using core::HttpQueue;
+
+  auto first       = insert("http://a.example/1", HttpQueue::priority_feed);
+  auto feed        = insert("http://a.example/2", HttpQueue::priority_feed);
+  auto interactive = insert("http://b.example/3");
+  auto watch       = insert("http://c.example/4", HttpQueue::priority_watch);
+
+  ASSERT_TRUE(first->is_busy());
+  ASSERT_EQ(m_queue.active(), 1u);
+  ASSERT_EQ(m_queue.pending(), 3u);
+
+  finish(first);
+  ASSERT_TRUE(interactive->is_busy());
+  ASSERT_FALSE(watch->is_busy());
+
+  finish(interactive);
+  ASSERT_TRUE(watch->is_busy());
+  ASSERT_FALSE(feed->is_busy());
+
+  finish(watch);
+  ASSERT_TRUE(feed->is_busy());
+  ASSERT_EQ(m_queue.pending(), 0u);
+}
+
+TEST_F(HttpQueueTest, test_max_per_host) {
+  m_queue.set_max_active(0);
+  m_queue.set_max_per_host(2);
+
+  auto first  = insert("http://a.example/1");
+  auto second = insert("http://A.example:80/2");
+  auto third  = insert("http://a.example/3");
+  auto other  = insert("http://b.example/4");
+
+  // The capped transfer doesn't hold back the one to another host.
+  ASSERT_TRUE(first->is_busy());
+  ASSERT_TRUE(second->is_busy());
+  ASSERT_FALSE(third->is_busy());
+  ASSERT_TRUE(other->is_busy());
+  ASSERT_EQ(m_queue.active(), 3u);
+
+  finish(other);
+  ASSERT_FALSE(third->is_busy());
+
+  finish(first);
+  ASSERT_TRUE(third->is_busy());
+}
+
+TEST_F(HttpQueueTest, test_skip_capped_host) {
+  m_queue.set_max_active(2);
+  m_queue.set_max_per_host(1);
+
+  auto first  = insert("http://a.example/1");
+  auto capped = insert("http://a.example/2");
+  auto other  = insert("http://b.example/3", core::HttpQueue::priority_feed);
+
+  // Started from a lower priority class, as the waiting transfer of
+  // the higher one is capped by its host.
+  ASSERT_TRUE(first->is_busy());
+  ASSERT_FALSE(capped->is_busy());
+  ASSERT_TRUE(other->is_busy());
+
+  finish(other);
+  ASSERT_FALSE(capped->is_busy());
+
+  finish(first);
+  ASSERT_TRUE(capped->is_busy());
+}
+
+TEST_F(HttpQueueTest, test_erase_pending) {
+  m_queue.set_max_active(1);
+
+  auto first   = insert("http://a.example/1");
+  auto pending = insert("http://b.example/2");
+
+  ASSERT_EQ(m_queue.pending(), 1u);
+
+  finish(pending);
+  ASSERT_EQ(m_queue.pending(), 0u);
+  ASSERT_EQ(m_queue.size(), 1u);
+
+  finish(first);
+  ASSERT_TRUE(m_queue.empty());
+  ASSERT_EQ(m_queue.active(), 0u);
+}
+
+TEST_F(HttpQueueTest, test_url_host) {
+  ASSERT_EQ(core::HttpQueue::url_host("http://Tracker.Example.COM/announce"),
+            "tracker.example.com");
+  ASSERT_EQ(core::HttpQueue::url_host("https://user:pw@example.com:8443/a"),
+            "example.com");
+  ASSERT_EQ(core::HttpQueue::url_host("http://a@b@example.com/c@d"),
+            "example.com");
+  ASSERT_EQ(core::HttpQueue::url_host("udp://[2001:DB8::1]:6969/announce"),
+            "[2001:db8::1]");
+  ASSERT_EQ(core::HttpQueue::url_host("http://[::1]/"), "[::1]");
+  ASSERT_EQ(core::HttpQueue::url_host("http://example.com?x=1"),
+            "example.com");
+  ASSERT_EQ(core::HttpQueue::url_host("example.com:80#x"), "example.com");
+  ASSERT_EQ(core::HttpQueue::url_host("http://"), "");
+}
@@ -0,0 +1,56 @@
+#include <fstream>
+
+#include "core/session_loader.h"
+#include "test/core/session_loader_test.h"
+
+static void
+write_file(const std::string& path, const std::string& content) {
+  std::ofstream(path, std::ios::binary) << content;
+}
+
+TEST_F(SessionLoaderTest, test_order) {
+  constexpr unsigned int count = 600;
+
+  core::SessionLoader::path_list paths;
+
+  for (unsigned int i = 0; i < count; i++) {
+    auto path  = m_directory.path() + "/" + std::to_string(i) + ".torrent";
+    auto value = std::to_string(i);
+
+    // Leave a few entries broken or without session sections.
+    if (i % 100 == 7)
+      write_file(path, "d5:index");
+    else
+      write_file(path, "d5:indexi" + value + "ee");
+
+    if (i % 2 == 0)
+      write_file(path + ".rtorrent", "d5:statei1ee");
+
+    paths.push_back(path);
+  }
+
+  paths.push_back(m_directory.path() + "/missing.torrent");
+
+  core::SessionLoader loader(paths, 4);
+  core::SessionEntry  entry;
+
+  for (unsigned int i = 0; i < count; i++) {
+    ASSERT_TRUE(loader.next(&entry));
+    ASSERT_EQ(entry.path, paths[i]);
+
+    if (i % 100 == 7) {
+      ASSERT_FALSE(entry.error.empty());
+      ASSERT_TRUE(entry.object == nullptr);
+      continue;
+    }
+
+    ASSERT_TRUE(entry.error.empty());
+    ASSERT_EQ(entry.object->get_key_value("index"), (int64_t)i);
+    ASSERT_EQ(entry.rtorrent.is_map(), i % 2 == 0);
+    ASSERT_TRUE(entry.resume.is_empty());
+  }
+
+  ASSERT_TRUE(loader.next(&entry));
+  ASSERT_EQ(entry.error, "Could not open file");
+  ASSERT_FALSE(loader.next(&entry));
+}
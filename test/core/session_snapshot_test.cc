@@ -0,0 +1,83 @@
+#include <fstream>
+
+#include "core/session_snapshot.h"
+#include "test/core/session_snapshot_test.h"
+
+static std::string
+make_id(unsigned int i) {
+  std::string id = std::to_string(i);
+  return std::string(core::SessionSnapshot::id_size - id.size(), '0') + id;
+}
+
+static torrent::Object
+make_section(int64_t value) {
+  torrent::Object object = torrent::Object::create_map();
+  object.insert_key("value", value);
+  return object;
+}
+
+static int64_t
+find_value(const core::SessionSnapshot& snapshot, unsigned int i) {
+  torrent::Object rtorrent;
+  torrent::Object resume;
+
+  if (!snapshot.find(make_id(i), &rtorrent, &resume))
+    return -1;
+
+  return rtorrent.get_key_value("value") + resume.get_key_value("value");
+}
+
+TEST_F(SessionSnapshotTest, test_replay) {
+  uint64_t file_size;
+
+  {
+    core::SessionSnapshot snapshot;
+    snapshot.open(m_path);
+
+    for (unsigned int i = 0; i < 100; i++)
+      ASSERT_TRUE(snapshot.write(make_id(i), make_section(i), make_section(0)));
+
+    ASSERT_TRUE(
+      snapshot.write(make_id(5), make_section(1000), make_section(1)));
+    ASSERT_TRUE(snapshot.erase(make_id(7)));
+    ASSERT_TRUE(snapshot.sync());
+
+    file_size = snapshot.file_size();
+  }
+
+  // Leave a torn record at the end, as a crash during a save would.
+  std::ofstream(m_path, std::ios::binary | std::ios::app) << "RTS1garbage";
+
+  core::SessionSnapshot snapshot;
+  snapshot.open(m_path);
+
+  ASSERT_EQ(snapshot.size(), 99u);
+  ASSERT_EQ(snapshot.file_size(), file_size);
+  ASSERT_EQ(find_value(snapshot, 5), 1001);
+  ASSERT_EQ(find_value(snapshot, 7), -1);
+  ASSERT_EQ(find_value(snapshot, 99), 99);
+
+  ASSERT_TRUE(snapshot.write(make_id(200), make_section(200), make_section(0)));
+  ASSERT_EQ(find_value(snapshot, 200), 200);
+}
+
+TEST_F(SessionSnapshotTest, test_compact) {
+  core::SessionSnapshot snapshot;
+  snapshot.open(m_path);
+
+  for (unsigned int round = 0; round < 10; round++)
+    for (unsigned int i = 0; i < 100; i++)
+      ASSERT_TRUE(
+        snapshot.write(make_id(i), make_section(round), make_section(i)));
+
+  ASSERT_TRUE(snapshot.file_size() > snapshot.live_size());
+  ASSERT_TRUE(snapshot.compact());
+  ASSERT_EQ(snapshot.file_size(), snapshot.live_size());
+  ASSERT_EQ(find_value(snapshot, 42), 9 + 42);
+
+  snapshot.close();
+  snapshot.open(m_path);
+
+  ASSERT_EQ(snapshot.size(), 100u);
+  ASSERT_EQ(find_value(snapshot, 42), 9 + 42);
+}
@@ -0,0 +1,50 @@
+#include <atomic>
+#include <vector>
+
+#include "core/session_writer.h"
+#include "test/core/session_writer_test.h"
+
+TEST_F(SessionWriterTest, test_order) {
+  core::SessionWriter writer;
+  std::vector<int>    order;
+
+  // Runs inline before the thread is started.
+  writer.push("a", 0, [&order]() {
+    order.push_back(-1);
+    return true;
+  });
+  ASSERT_EQ(order.size(), 1u);
+
+  writer.start();
+
+  // Larger than the limit, so each push waits for the previous job.
+  constexpr size_t bytes = core::SessionWriter::max_queued_bytes / 2 + 1;
+
+  for (int i = 0; i < 100; i++)
+    writer.push("a", bytes, [&order, i]() {
+      order.push_back(i);
+      return true;
+    });
+
+  writer.stop();
+
+  ASSERT_FALSE(writer.is_busy());
+  ASSERT_EQ(order.size(), 101u);
+
+  for (int i = 0; i < 100; i++)
+    ASSERT_EQ(order[i + 1], i);
+}
+
+TEST_F(SessionWriterTest, test_failed) {
+  core::SessionWriter writer;
+  writer.start();
+
+  writer.push("a", 0, []() { return false; });
+  writer.push("b", 0, []() { return true; });
+  writer.stop();
+
+  ASSERT_EQ(writer.failed_jobs(), 1u);
+  ASSERT_FALSE(writer.take_failed("b"));
+  ASSERT_TRUE(writer.take_failed("a"));
+  ASSERT_FALSE(writer.take_failed("a"));
+}
@@ -0,0 +1,287 @@
+#include <algorithm>
+#include <chrono>
+#include <iostream>
+#include <memory>
+#include <random>
+#include <vector>
+
+#include "command_helpers.h"
+#include "core/view.h"
+#include "rpc/parse_commands.h"
+#include "test/core/view_test.h"
+#include "test/helpers/assert.h"
+#include "test/helpers/commands.h"
+
+void
+ViewTest::SetUp() {
+  initialize_test_commands();
+}
+
+TEST_F(ViewTest, test_command) {
+  core::ViewCommand command;
+
+  ASSERT_TRUE(command.is_empty());
+
+  command.set("cat=a,$cat=b,c");
+  ASSERT_TRUE(command.call(rpc::make_target()).as_string() == "abc");
+  ASSERT_TRUE(command.call(rpc::make_target()).as_string() == "abc");
+
+  command.set("cat=d");
+  ASSERT_TRUE(command.call(rpc::make_target()).as_string() == "d");
+
+  command.set("test_view_missing=");
+  ASSERT_CATCH_INPUT_ERROR(command.call(rpc::make_target()));
+}
+
+TEST_F(ViewTest, test_command_erased) {
+  rpc::commands.call_command(
+    "method.insert.simple",
+    rpc::create_object_list("test_view_command.1", "cat=1"));
+
+  core::ViewCommand command;
+  command.set("test_view_command.1=");
+
+  ASSERT_TRUE(command.call(rpc::make_target()).as_string() == "1");
+
+  // The resolved command must not be used once erased.
+  rpc::commands.call_command("method.erase", "test_view_command.1");
+  ASSERT_CATCH_INPUT_ERROR(command.call(rpc::make_target()));
+}
+
+TEST_F(ViewTest, test_sort_order) {
+  core::ViewCommand command;
+
+  ASSERT_TRUE(command.sort_order() == core::ViewCommand::sort_none);
+
+  command.set("less=cat=x");
+  ASSERT_TRUE(command.sort_order() == core::ViewCommand::sort_less);
+  ASSERT_TRUE(command.call_sort_key(nullptr).as_string() == "x");
+
+  command.set("greater=cat=y");
+  ASSERT_TRUE(command.sort_order() == core::ViewCommand::sort_greater);
+  ASSERT_TRUE(command.call_sort_key(nullptr).as_string() == "y");
+
+  // Arguments that change with every call, or more than one getter,
+  // need the full comparison.
+  command.set("less=$cat=x");
+  ASSERT_TRUE(command.sort_order() == core::ViewCommand::sort_none);
+
+  command.set("less={cat=x,cat=y}");
+  ASSERT_TRUE(command.sort_order() == core::ViewCommand::sort_none);
+
+  command.set("cat=x");
+  ASSERT_TRUE(command.sort_order() == core::ViewCommand::sort_none);
+}
+
+static std::vector<int64_t> view_bench_keys;
+
+static int64_t
+view_bench_key(void* download) {
+  return view_bench_keys[(uintptr_t)download / 8 - 1];
+}
+
+// Downloads are fake pointers indexing 'view_bench_keys', and are
+// filtered out if their key is a multiple of the filter argument.
+static void
+view_bench_initialize() {
+  if (rpc::commands.find("test_view_bench.key") != rpc::commands.end())
+    return;
+
+  CMD2_ANY("test_view_bench.key", [](const auto& target, const auto&) {
+    return view_bench_key(std::get<1>(target));
+  }, true);
+  CMD2_ANY_STRING(
+    "test_view_bench.filter",
+    [](const auto& target, const std::string& arg) {
+      return (int64_t)(view_bench_key(std::get<1>(target)) % std::stoi(arg) !=
+                       0);
+    },
+    true);
+}
+
+TEST_F(ViewTest, test_update_dirty) {
+  view_bench_initialize();
+  view_bench_keys = { 3, 4, 5, 6 };
+
+  core::View view;
+  view.initialize("test_view_dirty");
+  view.set_sort_new("less=test_view_bench.key=");
+  view.set_filter("test_view_bench.filter=2");
+
+  auto download = [](unsigned int i) {
+    return reinterpret_cast<core::Download*>((i + 1) * 8);
+  };
+
+  for (unsigned int i = 0; i < 4; i++)
+    view.insert(download(i));
+  for (unsigned int i = 0; i < 4; i++)
+    view.filter_download(download(i));
+
+  ASSERT_EQ(view.size(), 2u);
+  ASSERT_EQ(*view.begin_visible(), download(0));
+
+  // Touching the view doesn't queue the focused download.
+  view.set_focus(view.begin_visible());
+  view.set_last_changed();
+  ASSERT_EQ(view.size_dirty(), 0u);
+
+  // Changes are only picked up once the downloads are updated.
+  view_bench_keys = { 3, 7, 1, 6 };
+  view.mark_dirty(download(1));
+  view.mark_dirty(download(2));
+  view.mark_dirty(download(1));
+
+  ASSERT_EQ(view.size_dirty(), 2u);
+  ASSERT_EQ(view.size(), 2u);
+
+  view.update_dirty();
+
+  ASSERT_EQ(view.size_dirty(), 0u);
+  ASSERT_EQ(view.size(), 3u);
+  ASSERT_EQ(*(view.begin_visible() + 0), download(2));
+  ASSERT_EQ(*(view.begin_visible() + 1), download(0));
+  ASSERT_EQ(*(view.begin_visible() + 2), download(1));
+
+  // Erased downloads left in the dirty list are skipped.
+  view.mark_dirty(download(3));
+  view.erase(download(3));
+  view.update_dirty();
+
+  ASSERT_EQ(view.size() + view.size_not_visible(), 3u);
+
+  view_bench_keys.clear();
+}
+
+TEST_F(ViewTest, test_filtered_order) {
+  view_bench_initialize();
+  view_bench_keys = { 1, 2, 3, 4, 5, 6 };
+
+  core::View view;
+  view.initialize("test_view_filtered");
+  view.set_filter("test_view_bench.filter=2");
+
+  auto download = [](unsigned int i) {
+    return reinterpret_cast<core::Download*>((i + 1) * 8);
+  };
+  auto filtered = [&view]() {
+    return std::vector<core::Download*>(view.begin_filtered(),
+                                        view.end_filtered());
+  };
+
+  for (unsigned int i = 0; i < 6; i++)
+    view.insert(download(i));
+
+  view.filter();
+
+  ASSERT_EQ(view.size(), 3u);
+  ASSERT_EQ(filtered(),
+            (std::vector<core::Download*>{
+              download(1), download(3), download(5) }));
+
+  // Newly filtered downloads are placed before the others.
+  view_bench_keys[0] = 2;
+  view.filter();
+
+  ASSERT_EQ(filtered(),
+            (std::vector<core::Download*>{
+              download(0), download(1), download(3), download(5) }));
+
+  // Downloads are found in the filtered part after it was reordered.
+  view.set_visible(download(3));
+  view.erase(download(5));
+
+  ASSERT_EQ(
+    filtered(),
+    (std::vector<core::Download*>{ download(0), download(1) }));
+
+  view.set_not_visible(download(2));
+  view.erase(download(1));
+
+  ASSERT_EQ(
+    filtered(),
+    (std::vector<core::Download*>{ download(0), download(2) }));
+  ASSERT_EQ(view.size(), 2u);
+
+  view_bench_keys.clear();
+}
+
+// Each of the views keeps the downloads whose key isn't a multiple of
+// its filter argument, sorted by key. Disabled as it mostly prints
+// timings, run it with --gtest_also_run_disabled_tests.
+TEST_F(ViewTest, DISABLED_benchmark_filter_download) {
+  constexpr unsigned int view_count     = 20;
+  constexpr unsigned int download_count = 20000;
+  constexpr unsigned int events         = 20000;
+
+  view_bench_initialize();
+
+  std::mt19937                             rng(download_count);
+  std::vector<core::Download*>             downloads;
+  std::vector<std::unique_ptr<core::View>> views;
+
+  for (unsigned int i = 0; i < download_count; i++) {
+    downloads.push_back(reinterpret_cast<core::Download*>((i + 1) * 8));
+    view_bench_keys.push_back(rng() % 1000000);
+  }
+
+  for (unsigned int i = 0; i < view_count; i++) {
+    views.emplace_back(new core::View);
+    views.back()->initialize("test_view_bench_" + std::to_string(i));
+    views.back()->set_sort_new("less=test_view_bench.key=");
+    views.back()->set_filter("test_view_bench.filter=" +
+                             std::to_string(i + 2));
+  }
+
+  auto start = std::chrono::steady_clock::now();
+
+  for (auto download : downloads) {
+    for (auto& view : views)
+      view->insert(download);
+    for (auto& view : views)
+      view->filter_download(download);
+  }
+
+  auto inserted = std::chrono::steady_clock::now();
+
+  for (unsigned int i = 0; i < events; i++) {
+    unsigned int index = rng() % download_count;
+
+    // Half of the events leave the key as is, like most state changes.
+    if (i % 2)
+      view_bench_keys[index] = rng() % 1000000;
+
+    for (auto& view : views)
+      view->filter_download(downloads[index]);
+  }
+
+  auto filtered = std::chrono::steady_clock::now();
+
+  for (unsigned int i = 0; i < view_count; i++) {
+    auto& view = views[i];
+
+    ASSERT_EQ(view->size() + view->size_not_visible(), download_count);
+    ASSERT_TRUE(std::is_sorted(
+      view->begin_visible(),
+      view->end_visible(),
+      [](core::Download* a, core::Download* b) {
+        return view_bench_key(a) < view_bench_key(b);
+      }));
+
+    for (auto itr = view->begin_visible(); itr != view->end_visible(); ++itr)
+      ASSERT_NE(view_bench_key(*itr) % (i + 2), 0);
+  }
+
+  std::cout << view_count << " views, " << download_count
+            << " torrents, per-insert: "
+            << std::chrono::duration<double, std::micro>(inserted - start)
+                   .count() /
+                 download_count
+            << " us, per-event: "
+            << std::chrono::duration<double, std::micro>(filtered - inserted)
+                   .count() /
+                 events
+            << " us" << std::endl;
+
+  views.clear();
+  view_bench_keys.clear();
+}
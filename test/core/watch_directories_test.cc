@@ -0,0 +1,158 @@
+#include <algorithm>
+#include <fstream>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <torrent/poll_epoll.h>
+
+#include "globals.h"
+#include "test/core/watch_directories_test.h"
+
+void
+WatchDirectoriesTest::SetUp() {
+  cachedTime = torrent::utils::timer::current();
+  m_poll     = torrent::PollEPoll::create(sysconf(_SC_OPEN_MAX));
+
+  ASSERT_TRUE(m_poll != nullptr);
+  ASSERT_TRUE(m_watch.open(m_poll));
+}
+
+void
+WatchDirectoriesTest::TearDown() {
+  m_watch.close();
+  delete m_poll;
+}
+
+void
+WatchDirectoriesTest::read_events() {
+  static_cast<torrent::Event&>(m_watch).event_read();
+}
+
+void
+WatchDirectoriesTest::advance(unsigned int seconds) {
+  cachedTime = cachedTime + torrent::utils::timer::from_seconds(seconds);
+  torrent::utils::priority_queue_perform(&taskScheduler, cachedTime);
+}
+
+void
+WatchDirectoriesTest::write_file(const std::string& path) {
+  std::ofstream file(path.c_str());
+  file << "d4:infode";
+}
+
+TEST_F(WatchDirectoriesTest, test_debounce) {
+  m_watch.set_debounce(2);
+  m_watch.insert(m_directory.path(), 0, [this](const std::string& path) {
+    m_reported.push_back(path);
+  });
+
+  ASSERT_EQ(m_watch.size(), 1u);
+
+  write_file(m_directory.path() + "/a.torrent");
+  write_file(m_directory.path() + "/b.txt");
+  read_events();
+
+  ASSERT_EQ(m_watch.pending(), 1u);
+
+  // Rewriting the file before the deadline moves it forward.
+  advance(1);
+  write_file(m_directory.path() + "/a.torrent");
+  read_events();
+  advance(1);
+
+  ASSERT_TRUE(m_reported.empty());
+
+  advance(1);
+
+  ASSERT_EQ(m_reported,
+            std::vector<std::string>{ m_directory.path() + "/a.torrent" });
+  ASSERT_EQ(m_watch.pending(), 0u);
+}
+
+TEST_F(WatchDirectoriesTest, test_recursive) {
+  ASSERT_EQ(::mkdir((m_directory.path() + "/old").c_str(), 0700), 0);
+  write_file(m_directory.path() + "/old/a.torrent");
+
+  m_watch.insert(m_directory.path(),
+                 core::WatchDirectories::flag_recursive,
+                 [this](const std::string& path) {
+                   m_reported.push_back(path);
+                 });
+
+  ASSERT_EQ(m_watch.size(), 2u);
+
+  // A directory created later is watched once its event is read.
+  ASSERT_EQ(::mkdir((m_directory.path() + "/new").c_str(), 0700), 0);
+  read_events();
+  write_file(m_directory.path() + "/new/b.torrent");
+  read_events();
+
+  ASSERT_EQ(m_watch.size(), 3u);
+
+  advance(m_watch.debounce());
+
+  // Files already there when watching started are left alone.
+  ASSERT_EQ(m_reported,
+            std::vector<std::string>{ m_directory.path() + "/new/b.torrent" });
+}
+
+TEST_F(WatchDirectoriesTest, test_scan_existing) {
+  ASSERT_EQ(::mkdir((m_directory.path() + "/old").c_str(), 0700), 0);
+  write_file(m_directory.path() + "/a.torrent");
+  write_file(m_directory.path() + "/old/b.torrent");
+
+  m_watch.set_scan_existing(true);
+  m_watch.insert(m_directory.path(),
+                 core::WatchDirectories::flag_recursive,
+                 [this](const std::string& path) {
+                   m_reported.push_back(path);
+                 });
+
+  ASSERT_EQ(m_watch.pending(), 2u);
+
+  advance(m_watch.debounce());
+  std::sort(m_reported.begin(), m_reported.end());
+
+  ASSERT_EQ(
+    m_reported,
+    (std::vector<std::string>{ m_directory.path() + "/a.torrent",
+                               m_directory.path() + "/old/b.torrent" }));
+}
+
+TEST_F(WatchDirectoriesTest, test_insert_twice) {
+  std::vector<std::string> first;
+
+  m_watch.insert(m_directory.path(), 0, [&first](const std::string& path) {
+    first.push_back(path);
+  });
+  m_watch.insert(m_directory.path() + "/", 0, [this](const std::string& path) {
+    m_reported.push_back(path);
+  });
+
+  ASSERT_EQ(m_watch.size(), 1u);
+
+  write_file(m_directory.path() + "/a.torrent");
+  read_events();
+  advance(m_watch.debounce());
+
+  ASSERT_TRUE(first.empty());
+  ASSERT_EQ(m_reported,
+            std::vector<std::string>{ m_directory.path() + "/a.torrent" });
+}
+
+TEST_F(WatchDirectoriesTest, test_close_in_slot) {
+  write_file(m_directory.path() + "/a.torrent");
+  write_file(m_directory.path() + "/b.torrent");
+
+  m_watch.set_scan_existing(true);
+  m_watch.insert(m_directory.path(), 0, [this](const std::string& path) {
+    m_reported.push_back(path);
+    m_watch.close();
+  });
+
+  advance(m_watch.debounce());
+
+  ASSERT_EQ(m_reported.size(), 1u);
+  ASSERT_FALSE(m_watch.is_open());
+  ASSERT_EQ(m_watch.pending(), 0u);
+}
@@ -1,6 +1,13 @@
 #include "test/rpc/command_map_test.h"
+
+#include <chrono>
+#include <iostream>
+#include <vector>
+
 #include "command_helpers.h"
 #include "rpc/command_map.h"
+#include "rpc/parse_commands.h"
+#include "test/helpers/commands.h"
 
 #undef CMD2_A_FUNCTION
 
@@ -40,3 +47,72 @@ TEST_F(CommandMapTest, test_basics) {
   ASSERT_TRUE(m_map.call_command("test_b", (int64_t)1).as_value() == 2);
   ASSERT_TRUE(m_map.call_command("any_string", "").as_value() == 3);
 }
+
+TEST_F(CommandMapTest, test_index) {
+  CMD2_ANY("test_a", &cmd_test_map_a, false);
+  CMD2_ANY("test_c", &cmd_test_map_a, false);
+  CMD2_ANY("test_b", &cmd_test_map_a, false);
+
+  m_map.create_redirect("test_d", "test_b", rpc::CommandMap::flag_dont_delete);
+
+  ASSERT_TRUE(m_map.has("test_d"));
+  ASSERT_TRUE(m_map.call_command("test_d", (int64_t)4).as_value() == 4);
+
+  m_map.erase(m_map.find("test_c"));
+
+  ASSERT_FALSE(m_map.has("test_c"));
+  ASSERT_FALSE(m_map.has("test_"));
+  ASSERT_TRUE(m_map.find("test_a")->first == std::string("test_a"));
+
+  // Iteration stays ordered by key.
+  std::vector<std::string> keys;
+
+  for (const auto& itr : m_map)
+    keys.push_back(itr.first);
+
+  ASSERT_TRUE(keys == std::vector<std::string>({ "test_a", "test_b", "test_d" }));
+}
+
+// Prints the cost of looking up every registered command through the
+// tree and through the index, run it with
+// --gtest_also_run_disabled_tests.
+TEST_F(CommandMapTest, DISABLED_benchmark_lookup) {
+  initialize_test_commands();
+
+  constexpr int rounds = 2000;
+
+  std::vector<std::string> keys;
+
+  for (const auto& itr : rpc::commands)
+    keys.push_back(itr.first);
+
+  const auto& tree = static_cast<const rpc::CommandMap::base_type&>(rpc::commands);
+
+  size_t found = 0;
+  auto   start = std::chrono::steady_clock::now();
+
+  for (int i = 0; i < rounds; i++)
+    for (const auto& key : keys)
+      found += tree.find(key.c_str()) != tree.end();
+
+  auto searched = std::chrono::steady_clock::now();
+
+  for (int i = 0; i < rounds; i++)
+    for (const auto& key : keys)
+      found += rpc::commands.find(key.c_str()) != rpc::commands.end();
+
+  auto hashed = std::chrono::steady_clock::now();
+
+  ASSERT_TRUE(found == 2 * rounds * keys.size());
+
+  const double lookups = (double)rounds * keys.size();
+
+  std::cout << keys.size() << " commands, per-lookup map: "
+            << std::chrono::duration<double, std::nano>(searched - start).count() /
+                 lookups
+            << " ns, per-lookup index: "
+            << std::chrono::duration<double, std::nano>(hashed - searched)
+                   .count() /
+                 lookups
+            << " ns" << std::endl;
+}
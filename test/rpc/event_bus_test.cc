@@ -0,0 +1,211 @@
+#include <algorithm>
+#include <chrono>
+#include <iostream>
+#include <map>
+#include <numeric>
+
+#include <nlohmann/json.hpp>
+
+#include "globals.h"
+#include "test/rpc/event_bus_test.h"
+
+void
+EventBusTest::SetUp() {
+  std::iota(m_hash.begin(), m_hash.end(), 0);
+
+  m_bus.open(
+    [this](std::function<void()> func) {
+      m_deferred.push_back(std::move(func));
+    },
+    [this](std::string_view topic, std::string_view message) {
+      m_frames.emplace_back(topic, message);
+    });
+
+  m_bus.subscribe("event.*");
+}
+
+void
+EventBusTest::run_deferred() {
+  auto deferred = std::move(m_deferred);
+
+  for (auto& func : deferred)
+    func();
+}
+
+TEST_F(EventBusTest, test_flush) {
+  for (int i = 0; i < 3; i++)
+    m_bus.push(m_hash, "event.download.resumed");
+
+  ASSERT_EQ(m_bus.pending(), 3u);
+
+  // Only one drain is queued until the loop gets to it.
+  m_bus.flush();
+  m_bus.flush();
+  ASSERT_EQ(m_deferred.size(), 1u);
+
+  run_deferred();
+  ASSERT_EQ(m_bus.pending(), 0u);
+  ASSERT_EQ(m_frames.size(), 1u);
+  ASSERT_EQ(m_frames[0].first, "event.*");
+
+  auto frame = nlohmann::json::parse(m_frames[0].second);
+
+  ASSERT_EQ(frame["jsonrpc"], "2.0");
+  ASSERT_EQ(frame["result"].size(), 3u);
+  ASSERT_EQ(frame["result"][0]["event"], "event.download.resumed");
+  ASSERT_EQ(frame["result"][0]["target"],
+            "000102030405060708090A0B0C0D0E0F10111213");
+  ASSERT_TRUE(frame["result"][0]["timestamp"].is_number());
+
+  // Nothing is queued or published once closed.
+  m_bus.close();
+  m_bus.push(m_hash, "event.download.closed");
+  m_bus.flush();
+
+  ASSERT_EQ(m_bus.pending(), 0u);
+  ASSERT_TRUE(m_deferred.empty());
+}
+
+TEST_F(EventBusTest, test_topics) {
+  auto hash_topic = "hash.000102030405060708090a0b0c0d0e0f10111213";
+
+  ASSERT_EQ(rpc::EventBus::normalize_topic("event.*"), "event.*");
+  ASSERT_EQ(rpc::EventBus::normalize_topic("event.download.hash_done"),
+            "event.download.hash_done");
+  ASSERT_EQ(rpc::EventBus::normalize_topic(hash_topic),
+            "hash.000102030405060708090A0B0C0D0E0F10111213");
+  ASSERT_EQ(rpc::EventBus::normalize_topic("view.main"), "view.main");
+  ASSERT_TRUE(rpc::EventBus::normalize_topic("event.download.\"").empty());
+  ASSERT_TRUE(rpc::EventBus::normalize_topic("hash.0001").empty());
+  ASSERT_TRUE(rpc::EventBus::normalize_topic("view.").empty());
+  ASSERT_TRUE(rpc::EventBus::normalize_topic("other").empty());
+
+  m_bus.unsubscribe("event.*");
+  m_bus.subscribe("event.download.finished");
+  m_bus.subscribe(rpc::EventBus::normalize_topic(hash_topic));
+  m_bus.subscribe("view.seeding");
+
+  ASSERT_TRUE(m_bus.has_view_subscribers());
+
+  m_bus.set_views({ "main", "seeding" });
+
+  torrent::HashString other;
+  std::fill(other.begin(), other.end(), 1);
+
+  m_bus.push(other, "event.download.finished", 0x2);
+  m_bus.push(other, "event.download.paused", 0x1);
+  m_bus.push(m_hash, "event.download.paused", 0x3);
+  m_bus.flush();
+  run_deferred();
+
+  std::map<std::string, size_t> sizes;
+
+  for (const auto& frame : m_frames)
+    sizes[frame.first] = nlohmann::json::parse(frame.second)["result"].size();
+
+  ASSERT_EQ(sizes,
+            (std::map<std::string, size_t>{
+              { "event.download.finished", 1 },
+              { "hash.000102030405060708090A0B0C0D0E0F10111213", 1 },
+              { "view.seeding", 2 } }));
+
+  m_bus.unsubscribe("view.seeding");
+  ASSERT_FALSE(m_bus.has_view_subscribers());
+}
+
+TEST_F(EventBusTest, test_overflow) {
+  const uint32_t count = rpc::EventBus::ring_size + 10;
+
+  for (uint32_t i = 0; i < count; i++)
+    m_bus.push(m_hash, "event.download.inserted");
+
+  ASSERT_EQ(m_bus.pending(), count);
+
+  m_bus.flush();
+  run_deferred();
+  ASSERT_EQ(m_bus.pending(), 10u);
+
+  m_bus.flush();
+  run_deferred();
+  ASSERT_EQ(m_bus.pending(), 0u);
+
+  ASSERT_EQ(m_frames.size(), 2u);
+  ASSERT_EQ(nlohmann::json::parse(m_frames[0].second)["result"].size(),
+            rpc::EventBus::ring_size);
+  ASSERT_EQ(nlohmann::json::parse(m_frames[1].second)["result"].size(), 10u);
+}
+
+// The flush task waits another interval while the ring is full, instead
+// of being run again in the same scheduler pass.
+TEST_F(EventBusTest, test_overflow_task) {
+  const uint32_t count    = rpc::EventBus::ring_size + 10;
+  const auto     interval = torrent::utils::timer::from_milliseconds(
+    m_bus.flush_interval());
+
+  cachedTime = torrent::utils::timer::current();
+
+  for (uint32_t i = 0; i < count; i++)
+    m_bus.push(m_hash, "event.download.inserted");
+
+  cachedTime = cachedTime + interval;
+  torrent::utils::priority_queue_perform(&taskScheduler, cachedTime);
+
+  ASSERT_EQ(m_deferred.size(), 1u);
+  run_deferred();
+  ASSERT_EQ(m_bus.pending(), 10u);
+
+  cachedTime = cachedTime + interval;
+  torrent::utils::priority_queue_perform(&taskScheduler, cachedTime);
+
+  run_deferred();
+  ASSERT_EQ(m_bus.pending(), 0u);
+  ASSERT_EQ(m_frames.size(), 2u);
+}
+
+// Compares pushing events into the bus against building a json frame
+// for each of them. Prints timings, run it with
+// --gtest_also_run_disabled_tests.
+TEST_F(EventBusTest, DISABLED_benchmark_push) {
+  constexpr unsigned int events = 10000;
+
+  // What publishing a frame for each event used to cost.
+  size_t bytes = 0;
+  auto   start = std::chrono::steady_clock::now();
+
+  for (unsigned int i = 0; i < events; i++) {
+    nlohmann::json message = {
+      { "jsonrpc", "2.0" },
+      { "result",
+        { { "target", "000102030405060708090A0B0C0D0E0F10111213" },
+          { "event", "event.download.resumed" },
+          { "timestamp", 0 } } }
+    };
+
+    bytes += message.dump().size();
+  }
+
+  auto dumped = std::chrono::steady_clock::now();
+
+  for (unsigned int i = 0; i < events; i++)
+    m_bus.push(m_hash, "event.download.resumed");
+
+  auto pushed = std::chrono::steady_clock::now();
+
+  m_bus.flush();
+  run_deferred();
+
+  auto drained = std::chrono::steady_clock::now();
+
+  ASSERT_TRUE(bytes != 0);
+  ASSERT_EQ(m_frames.size(), 1u);
+
+  auto per_event = [](auto duration) {
+    return std::chrono::duration<double, std::nano>(duration).count() / events;
+  };
+
+  std::cout << events
+            << " events, per-event json: " << per_event(dumped - start)
+            << " ns, push: " << per_event(pushed - dumped)
+            << " ns, drain: " << per_event(drained - pushed) << " ns"
+            << std::endl;
+}
@@ -0,0 +1,97 @@
+#include <chrono>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "rpc/parse_commands.h"
+#include "test/helpers/assert.h"
+#include "test/helpers/commands.h"
+#include "test/rpc/parse_commands_test.h"
+
+void
+ParseCommandsTest::SetUp() {
+  initialize_test_commands();
+}
+
+TEST_F(ParseCommandsTest, test_compile) {
+  rpc::parsed_command cmd = rpc::parse_command_compile("cat=foo,bar");
+
+  ASSERT_TRUE(cmd.itr != rpc::commands.end());
+  ASSERT_FALSE(cmd.execute);
+  ASSERT_TRUE(rpc::call_parsed_command(cmd, rpc::make_target()).as_string() ==
+              "foobar");
+
+  // Calling the same plan again must not consume the arguments.
+  ASSERT_TRUE(rpc::call_parsed_command(cmd, rpc::make_target()).as_string() ==
+              "foobar");
+}
+
+TEST_F(ParseCommandsTest, test_compile_execute) {
+  rpc::parsed_command cmd = rpc::parse_command_compile("cat=a,$cat=b,c");
+
+  ASSERT_TRUE(cmd.execute);
+  ASSERT_TRUE(rpc::call_parsed_command(cmd, rpc::make_target()).as_string() ==
+              "abc");
+  ASSERT_TRUE(rpc::call_parsed_command(cmd, rpc::make_target()).as_string() ==
+              "abc");
+}
+
+TEST_F(ParseCommandsTest, test_compile_empty) {
+  rpc::parsed_command cmd = rpc::parse_command_compile("  # comment");
+
+  ASSERT_TRUE(cmd.itr == rpc::commands.end());
+  ASSERT_TRUE(rpc::call_parsed_command(cmd, rpc::make_target()).is_empty());
+}
+
+TEST_F(ParseCommandsTest, test_compile_errors) {
+  ASSERT_CATCH_INPUT_ERROR(
+    { rpc::parse_command_compile("test_compile_errors.missing="); });
+  ASSERT_CATCH_INPUT_ERROR({ rpc::parse_command_compile("cat"); });
+  ASSERT_CATCH_INPUT_ERROR({ rpc::parse_command_compile("cat=a b"); });
+}
+
+// Compares the per-row cost of re-parsing a set of multicall columns
+// against calling the pre-parsed commands. Disabled as it only prints
+// timings, run it with --gtest_also_run_disabled_tests.
+TEST_F(ParseCommandsTest, DISABLED_benchmark_multicall_rows) {
+  constexpr int rows = 20000;
+
+  const std::vector<std::string> columns = {
+    "cat=x", "cat=a,b", "cat=1234", "cat=$cat=42,x", "cat={a,b},c",
+  };
+
+  auto start = std::chrono::steady_clock::now();
+
+  for (int i = 0; i < rows; i++)
+    for (const auto& column : columns)
+      rpc::parse_command(rpc::make_target(),
+                         column.c_str(),
+                         column.c_str() + column.size());
+
+  auto parsed = std::chrono::steady_clock::now();
+
+  rpc::parsed_command_list plan;
+
+  for (const auto& column : columns)
+    plan.push_back(rpc::parse_command_compile(column));
+
+  for (int i = 0; i < rows; i++)
+    for (const auto& cmd : plan)
+      rpc::call_parsed_command(cmd, rpc::make_target());
+
+  auto compiled = std::chrono::steady_clock::now();
+
+  for (unsigned int i = 0; i < columns.size(); i++)
+    ASSERT_TRUE(
+      rpc::parse_command_single(rpc::make_target(), columns[i]).as_string() ==
+      rpc::call_parsed_command(plan[i], rpc::make_target()).as_string());
+
+  std::cout << "per-row parse: "
+            << std::chrono::duration<double, std::nano>(parsed - start).count() /
+                 rows
+            << " ns, per-row compiled: "
+            << std::chrono::duration<double, std::nano>(compiled - parsed)
+                   .count() /
+                 rows
+            << " ns" << std::endl;
+}
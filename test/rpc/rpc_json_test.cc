@@ -0,0 +1,112 @@
+#include "test/rpc/rpc_json_test.h"
+
+#ifdef HAVE_JSON
+
+#include <chrono>
+#include <iostream>
+
+#include <nlohmann/json.hpp>
+#include <torrent/object.h>
+
+using nlohmann::json;
+
+// The tree based conversion previously used for responses.
+static json
+object_to_json_tree(const torrent::Object& object) {
+  switch (object.type()) {
+    case torrent::Object::TYPE_VALUE:
+      return object.as_value();
+    case torrent::Object::TYPE_STRING:
+      return object.as_string();
+    case torrent::Object::TYPE_LIST: {
+      json result = json::array();
+      for (const auto& element : object.as_list())
+        result.push_back(object_to_json_tree(element));
+      return result;
+    }
+    case torrent::Object::TYPE_MAP: {
+      json result = json::object();
+      for (const auto& [k, v] : object.as_map())
+        result.emplace(k, object_to_json_tree(v));
+      return result;
+    }
+    default:
+      return 0;
+  }
+}
+
+static std::string
+dump_tree(const torrent::Object& object) {
+  return object_to_json_tree(object).dump(
+    -1, ' ', false, json::error_handler_t::replace);
+}
+
+static std::string
+write_object(const torrent::Object& object) {
+  std::string result;
+  rpc::json_write_object(object, &result);
+  return result;
+}
+
+TEST_F(RpcJsonTest, test_write_basics) {
+  ASSERT_EQ(write_object(int64_t(-42)), "-42");
+  ASSERT_EQ(write_object(std::string("a\"b\\c\n\x01")),
+            dump_tree(std::string("a\"b\\c\n\x01")));
+  ASSERT_EQ(write_object(std::string("\xC3\xA5\xFF\xE2\x82")),
+            dump_tree(std::string("\xC3\xA5\xFF\xE2\x82")));
+  ASSERT_EQ(write_object(torrent::Object::create_list()), "[]");
+  ASSERT_EQ(write_object(torrent::Object::create_map()), "{}");
+
+  torrent::Object map = torrent::Object::create_map();
+  map.insert_key("b", int64_t(1));
+  map.insert_key("a", "x");
+  map.insert_key("c", torrent::Object::create_list());
+  map.get_key("c").as_list().push_back(int64_t(2));
+  map.get_key("c").as_list().push_back("y");
+
+  ASSERT_EQ(write_object(map), dump_tree(map));
+  ASSERT_EQ(write_object(map), "{\"a\":\"x\",\"b\":1,\"c\":[2,\"y\"]}");
+}
+
+// Compares serializing a d.multicall sized result through a json tree
+// against writing it directly. Disabled as it only prints timings, run
+// it with --gtest_also_run_disabled_tests.
+TEST_F(RpcJsonTest, DISABLED_benchmark_multicall_result) {
+  constexpr int rows    = 20000;
+  constexpr int columns = 20;
+
+  torrent::Object result = torrent::Object::create_list();
+
+  for (int i = 0; i < rows; i++) {
+    torrent::Object::list_type& row =
+      result.as_list()
+        .insert(result.as_list().end(), torrent::Object::create_list())
+        ->as_list();
+
+    for (int j = 0; j < columns; j++) {
+      if (j % 2)
+        row.push_back(int64_t(i) * j);
+      else
+        row.push_back("torrent name " + std::to_string(i));
+    }
+  }
+
+  auto        start = std::chrono::steady_clock::now();
+  std::string tree  = dump_tree(result);
+  auto        mid   = std::chrono::steady_clock::now();
+
+  std::string direct;
+  rpc::json_write_object(result, &direct);
+
+  auto end = std::chrono::steady_clock::now();
+
+  ASSERT_EQ(tree, direct);
+
+  std::cout << "json tree: "
+            << std::chrono::duration<double, std::milli>(mid - start).count()
+            << " ms, direct: "
+            << std::chrono::duration<double, std::milli>(end - mid).count()
+            << " ms" << std::endl;
+}
+
+#endif
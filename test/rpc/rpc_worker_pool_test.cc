@@ -0,0 +1,127 @@
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <thread>
+
+#include <torrent/exceptions.h>
+
+#include "test/helpers/assert.h"
+#include "test/rpc/rpc_worker_pool_test.h"
+
+TEST_F(RpcWorkerPoolTest, test_jobs) {
+  rpc::RpcWorkerPool pool;
+  std::atomic<int>   count{ 0 };
+  std::atomic<int>   foreign{ 0 };
+
+  const auto caller = std::this_thread::get_id();
+
+  pool.resize(4);
+  ASSERT_EQ(pool.size(), 4u);
+
+  for (int i = 0; i != 1000; ++i)
+    pool.push([&]() {
+      count++;
+
+      if (std::this_thread::get_id() != caller)
+        foreign++;
+    });
+
+  for (int i = 0; i != 1000 && count != 1000; ++i)
+    std::this_thread::sleep_for(std::chrono::milliseconds(10));
+
+  pool.stop();
+
+  ASSERT_EQ(pool.size(), 0u);
+  ASSERT_EQ(count, 1000);
+  ASSERT_EQ(foreign, 1000);
+}
+
+TEST_F(RpcWorkerPoolTest, test_resize) {
+  rpc::RpcWorkerPool pool;
+  std::atomic<int>   count{ 0 };
+
+  pool.resize(4);
+  pool.resize(1);
+
+  for (int i = 0; i != 100; ++i)
+    pool.push([&]() { count++; });
+
+  // Retired threads finish the queue before exiting.
+  pool.resize(0);
+
+  // Without threads the job runs on the calling thread.
+  const auto caller = std::this_thread::get_id();
+  bool       inline_call = false;
+
+  pool.push([&]() { inline_call = std::this_thread::get_id() == caller; });
+  ASSERT_TRUE(inline_call);
+
+  for (int i = 0; i != 1000 && count != 100; ++i)
+    std::this_thread::sleep_for(std::chrono::milliseconds(10));
+
+  pool.stop();
+  ASSERT_EQ(count, 100);
+
+  ASSERT_CATCH_INPUT_ERROR(pool.resize(rpc::RpcWorkerPool::max_size + 1));
+}
+
+TEST_F(RpcWorkerPoolTest, test_join_retired) {
+  rpc::RpcWorkerPool pool;
+
+  for (int i = 0; i != 100; ++i) {
+    pool.resize(4);
+    pool.resize(0);
+  }
+
+  // Retired threads are joined by the next resize after they exit.
+  for (int i = 0; i != 100 && pool.thread_count() != 0; ++i) {
+    std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    pool.resize(0);
+  }
+
+  ASSERT_EQ(pool.thread_count(), 0u);
+
+  pool.resize(2);
+  ASSERT_EQ(pool.thread_count(), 2u);
+  pool.stop();
+  ASSERT_EQ(pool.thread_count(), 0u);
+}
+
+TEST_F(RpcWorkerPoolTest, test_stop_queued) {
+  rpc::RpcWorkerPool pool;
+  std::atomic<bool>  started{ false };
+  std::atomic<bool>  released{ false };
+  std::atomic<int>   count{ 0 };
+  auto               tracked = std::make_shared<int>(0);
+
+  pool.resize(1);
+
+  // Stands in for a job waiting on the global lock held by the caller
+  // of stop().
+  pool.push([&]() {
+    started = true;
+
+    while (!released)
+      std::this_thread::yield();
+  });
+
+  while (!started)
+    std::this_thread::yield();
+
+  for (int i = 0; i != 100; ++i)
+    pool.push([&count, tracked]() { count++; });
+
+  // The threads are taken by stop() together with the queued jobs.
+  std::thread release([&]() {
+    while (pool.thread_count() != 0)
+      std::this_thread::yield();
+
+    released = true;
+  });
+
+  pool.stop();
+  release.join();
+
+  ASSERT_EQ(count, 0);
+  ASSERT_EQ(tracked.use_count(), 1);
+}
@@ -0,0 +1,103 @@
+#include "buildinfo.h"
+
+#include <fcntl.h>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <torrent/hash_string.h>
+
+#include "rpc/parse_commands.h"
+#include "rpc/scgi.h"
+#include "test/helpers/commands.h"
+#include "test/rpc/scgi_test.h"
+
+void
+SCgiTest::SetUp() {
+  initialize_test_commands();
+
+  if (!rpc::rpc.is_initialized())
+    rpc::rpc.initialize([](const char*) { return nullptr; },
+                        [](core::Download*, uint32_t) { return nullptr; },
+                        [](core::Download*, uint32_t) { return nullptr; },
+                        [](core::Download*, const torrent::HashString&) {
+                          return nullptr;
+                        });
+}
+
+#ifdef HAVE_JSON
+
+static long
+resident_pages() {
+  long          size     = 0;
+  long          resident = 0;
+  std::ifstream statm("/proc/self/statm");
+
+  statm >> size >> resident;
+  return resident;
+}
+
+// Sends 'requests' requests through 'process_and_send' to a
+// non-blocking socket and checks that memory use stays flat. The
+// responses are read after each request, so the socket never fills.
+static void
+soak_process_and_send(int requests) {
+  const int warmup = requests / 10;
+
+  int fds[2];
+  ASSERT_EQ(::socketpair(AF_UNIX, SOCK_STREAM, 0, fds), 0);
+  ASSERT_NE(::fcntl(fds[0], F_SETFL, O_NONBLOCK), -1);
+  ASSERT_NE(::fcntl(fds[1], F_SETFL, O_NONBLOCK), -1);
+
+  const std::string body =
+    R"({"jsonrpc":"2.0","method":"cat","params":["","soak"],"id":1})";
+  const std::string headers = std::string("CONTENT_LENGTH") + '\0' +
+                              std::to_string(body.size()) + '\0' +
+                              "CONTENT_TYPE" + '\0' + "application/json" +
+                              '\0';
+  const std::string request =
+    std::to_string(headers.size()) + ":" + headers + "," + body;
+
+  long   baseline = 0;
+  size_t received = 0;
+  char   buffer[65536];
+
+  for (int i = 0; i < requests; i++) {
+    if (i == warmup)
+      baseline = resident_pages();
+
+    ASSERT_TRUE(rpc::SCgi::process_and_send(
+      fds[0], request.c_str(), request.size(), true));
+
+    ssize_t bytes;
+
+    while ((bytes = ::read(fds[1], buffer, sizeof(buffer))) > 0)
+      received += bytes;
+  }
+
+  long growth = resident_pages() - baseline;
+
+  ::close(fds[0]);
+  ::close(fds[1]);
+
+  ASSERT_TRUE(received > (size_t)requests * body.size());
+
+  // Allow for a few pages of allocator noise, the previous code leaked
+  // a buffer per response.
+  ASSERT_LT(growth * ::sysconf(_SC_PAGESIZE), 4 << 20)
+    << "resident memory grew by " << growth << " pages";
+}
+
+// The leaked buffer per response shows well within this count.
+TEST_F(SCgiTest, soak_process_and_send) {
+  soak_process_and_send(50000);
+}
+
+// Takes too long for every test run, use --gtest_also_run_disabled_tests.
+TEST_F(SCgiTest, DISABLED_soak_process_and_send_long) {
+  soak_process_and_send(1000000);
+}
+
+#endif
@@ -1,26 +1,13 @@
 #include <iostream>
 
-#include "control.h"
-#include "globals.h"
 #include "rpc/parse_commands.h"
 #include "test/helpers/assert.h"
+#include "test/helpers/commands.h"
 #include "test/src/command_dynamic_test.h"
 
-void
-initialize_command_logic();
-void
-initialize_command_dynamic();
-
 void
 CommandDynamicTest::SetUp() {
-  if (rpc::commands.empty()) {
-    setlocale(LC_ALL, "");
-    cachedTime = torrent::utils::timer::current();
-    control    = new Control;
-
-    initialize_command_logic();
-    initialize_command_dynamic();
-  }
+  initialize_test_commands();
 }
 
 TEST_F(CommandDynamicTest, test_basics) {
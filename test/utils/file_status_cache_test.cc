@@ -0,0 +1,54 @@
+#include <fstream>
+#include <string>
+#include <unistd.h>
+
+#include <torrent/exceptions.h>
+
+#include "test/utils/file_status_cache_test.h"
+
+TEST_F(FileStatusCacheTest, test_insert) {
+  utils::FileStatusCache cache;
+
+  ASSERT_FALSE(cache.insert(m_path + "0"));
+
+  std::ofstream(m_path + "0") << "x";
+  std::ofstream(m_path + "1") << "x";
+
+  ASSERT_TRUE(cache.insert(m_path + "0"));
+  ASSERT_FALSE(cache.insert(m_path + "0"));
+  ASSERT_TRUE(cache.insert(m_path + "1"));
+  ASSERT_EQ(cache.size(), 2u);
+
+  // Not cached when throwing, so errors aren't suppressed.
+  ASSERT_TRUE(cache.insert(m_path + "0", true));
+  ASSERT_THROW(cache.insert(m_path + "2", true), torrent::input_error);
+}
+
+TEST_F(FileStatusCacheTest, test_prune_step) {
+  utils::FileStatusCache cache;
+
+  for (int i = 0; i < 10; i++) {
+    std::ofstream(m_path + std::to_string(i)) << "x";
+    ASSERT_TRUE(cache.insert(m_path + std::to_string(i)));
+  }
+
+  for (int i = 0; i < 10; i += 2)
+    ::unlink((m_path + std::to_string(i)).c_str());
+
+  ASSERT_FALSE(cache.prune_step(4));
+  ASSERT_EQ(cache.size(), 8u);
+
+  // Freed slots are reused by new entries while the pass goes on.
+  std::ofstream(m_path + "0") << "x";
+  ASSERT_TRUE(cache.insert(m_path + "0"));
+
+  ASSERT_FALSE(cache.prune_step(4));
+  ASSERT_TRUE(cache.prune_step(4));
+  ASSERT_EQ(cache.size(), 6u);
+
+  ASSERT_FALSE(cache.insert(m_path + "0"));
+  ASSERT_FALSE(cache.insert(m_path + "1"));
+
+  cache.prune();
+  ASSERT_EQ(cache.size(), 6u);
+}
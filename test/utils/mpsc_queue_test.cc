@@ -0,0 +1,124 @@
+#include <atomic>
+#include <chrono>
+#include <iostream>
+#include <memory>
+#include <thread>
+#include <vector>
+
+#include "test/utils/mpsc_queue_test.h"
+
+TEST_F(MpscQueueTest, test_consume) {
+  queue_type       queue;
+  std::vector<int> result;
+
+  ASSERT_TRUE(queue.empty());
+  ASSERT_EQ(queue.consume([](auto&& func) { func(); }), 0u);
+
+  for (int i = 0; i < 3; i++)
+    queue.push([&result, i] { result.push_back(i); });
+
+  ASSERT_FALSE(queue.empty());
+
+  // Items pushed while consuming are left for the next call.
+  ASSERT_EQ(queue.consume([&](auto&& func) {
+              func();
+              queue.push([&result] { result.push_back(3); });
+            }),
+            3u);
+  ASSERT_EQ(result, std::vector<int>({ 0, 1, 2 }));
+
+  ASSERT_EQ(queue.consume([](auto&& func) { func(); }), 3u);
+  ASSERT_EQ(result, std::vector<int>({ 0, 1, 2, 3, 3, 3 }));
+  ASSERT_TRUE(queue.empty());
+
+  // Captures of items left in the queue are released with it.
+  auto shared = std::make_shared<int>();
+
+  {
+    queue_type other;
+    other.push([shared] {});
+    ASSERT_EQ(shared.use_count(), 2);
+  }
+
+  ASSERT_EQ(shared.use_count(), 1);
+}
+
+TEST_F(MpscQueueTest, test_producers) {
+  constexpr int producers = 8;
+  constexpr int items     = 50000;
+
+  queue_type               queue;
+  std::atomic<int>         running{ producers };
+  std::vector<int>         next(producers, 0);
+  bool                     ordered = true;
+  std::vector<std::thread> threads;
+
+  for (int p = 0; p < producers; p++)
+    threads.emplace_back([&, p] {
+      for (int i = 0; i < items; i++)
+        queue.push([&, p, i] {
+          ordered = ordered && next[p] == i;
+          next[p] = i + 1;
+        });
+
+      running--;
+    });
+
+  size_t consumed = 0;
+
+  while (running != 0 || !queue.empty())
+    consumed += queue.consume([](auto&& func) { func(); });
+
+  for (auto& thread : threads)
+    thread.join();
+
+  consumed += queue.consume([](auto&& func) { func(); });
+
+  ASSERT_EQ(consumed, (size_t)producers * items);
+  ASSERT_TRUE(ordered);
+
+  for (int p = 0; p < producers; p++)
+    ASSERT_EQ(next[p], items);
+}
+
+// Prints the per-push cost with a growing number of producers, run it
+// with --gtest_also_run_disabled_tests.
+TEST_F(MpscQueueTest, DISABLED_benchmark_push) {
+  constexpr int items = 200000;
+
+  for (int producers : { 1, 4 }) {
+    queue_type               queue;
+    std::atomic<int>         running{ producers };
+    std::atomic<int>         total_ns{ 0 };
+    std::vector<std::thread> threads;
+
+    for (int p = 0; p < producers; p++)
+      threads.emplace_back([&] {
+        auto start = std::chrono::steady_clock::now();
+
+        for (int i = 0; i < items; i++)
+          queue.push([] {});
+
+        total_ns += std::chrono::duration_cast<std::chrono::nanoseconds>(
+                      std::chrono::steady_clock::now() - start)
+                      .count() /
+                    items;
+        running--;
+      });
+
+    size_t consumed = 0;
+
+    while (running != 0)
+      consumed += queue.consume([](auto&& func) { func(); });
+
+    for (auto& thread : threads)
+      thread.join();
+
+    consumed += queue.consume([](auto&& func) { func(); });
+
+    ASSERT_EQ(consumed, (size_t)producers * items);
+
+    std::cout << producers << " producers, per-push: "
+              << total_ns / producers << " ns" << std::endl;
+  }
+}
@@ -0,0 +1,51 @@
+#include <regex>
+
+#include "test/utils/pattern_cache_test.h"
+
+TEST_F(PatternCacheTest, test_fast_paths) {
+  ASSERT_TRUE(utils::Pattern("foo").type() == utils::Pattern::match_literal);
+  ASSERT_TRUE(utils::Pattern("foo.*").type() == utils::Pattern::match_prefix);
+  ASSERT_TRUE(utils::Pattern(".*\\.mkv").type() ==
+              utils::Pattern::match_suffix);
+  ASSERT_TRUE(utils::Pattern(".*foo.*").type() ==
+              utils::Pattern::match_contains);
+  ASSERT_TRUE(utils::Pattern("foo\\.*").type() == utils::Pattern::match_regex);
+  ASSERT_TRUE(utils::Pattern("a[0-9]").type() == utils::Pattern::match_regex);
+  ASSERT_FALSE(utils::Pattern("a[0-9").is_valid());
+}
+
+TEST_F(PatternCacheTest, test_same_as_regex) {
+  const char* patterns[] = { "foo", ".*foo",    "foo.*",    ".*foo.*",
+                             ".*",  "foo\\.*",  ".*\\.mkv", "a\\.b",
+                             "a.b", "abc[0-9]", "a\\d" };
+  const char* strings[]  = { "foo", "xfoo",  "foox",  "xfooy", "foo..",
+                             "",    "a.mkv", "a.b",   "axb",   "abc1",
+                             "a1",  "foo\n", "\nfoo", "fo" };
+
+  for (auto pattern : patterns) {
+    utils::Pattern compiled(pattern);
+    std::regex     re(pattern);
+
+    for (auto str : strings)
+      ASSERT_EQ(std::regex_match(std::string(str), re), compiled.match(str))
+        << "pattern: '" << pattern << "' string: '" << str << "'";
+  }
+}
+
+TEST_F(PatternCacheTest, test_cache) {
+  auto first = m_cache.insert("a[0-9");
+  ASSERT_TRUE(first.second);
+  ASSERT_FALSE(first.first->is_valid());
+  ASSERT_FALSE(first.first->error().empty());
+
+  // Invalid patterns are only reported the first time.
+  auto second = m_cache.insert("a[0-9");
+  ASSERT_FALSE(second.second);
+  ASSERT_TRUE(first.first == second.first);
+  ASSERT_FALSE(second.first->match("a1"));
+
+  for (size_t i = 0; i < utils::PatternCache::max_size * 2; i++)
+    m_cache.insert(std::to_string(i));
+
+  ASSERT_TRUE(m_cache.size() <= utils::PatternCache::max_size);
+}